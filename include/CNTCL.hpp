@@ -9,6 +9,22 @@
 #include <optional>
 #include <bit>
 #include <thread>
+#include <barrier>
+#include <array>
+#include <algorithm>
+#include <span>
+#include <utility>
+#include <cmath>
+#include <compare>
+#include <string>
+#include <string_view>
+#include <memory>
+#include <memory_resource>
+#include <cstdio>
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <cassert>
 
 // Architecture-specific includes
 #if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
@@ -21,14 +37,524 @@
     #define HAS_ARM_NEON 1
 #endif
 
+// POSIX memory mapping for prime tables and the hugepage arena
+#if defined(__unix__) || defined(__APPLE__)
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+    #define HAS_POSIX_MMAP 1
+#endif
+
 namespace CNTCL {
 
+// ===== Integer traits =====
+
+template <unsigned Bits>
+struct uint_t;
+
+// Built-in integral types, including the 128-bit compiler extensions
+template <typename T>
+inline constexpr bool is_builtin_integer_v = std::is_integral_v<T> ||
+    std::is_same_v<T, __int128> || std::is_same_v<T, unsigned __int128>;
+
+// Types the number theory templates accept: built-in integers and uint_t<Bits>
+template <typename T>
+struct is_integer : std::bool_constant<is_builtin_integer_v<T>> {};
+template <unsigned Bits>
+struct is_integer<uint_t<Bits>> : std::true_type {};
+template <typename T>
+inline constexpr bool is_integer_v = is_integer<T>::value;
+
+// Type holding the full product of two T values
+template <typename T, typename = void>
+struct wide_integer {};
+template <typename T>
+struct wide_integer<T, std::enable_if_t<std::is_integral_v<T> && (sizeof(T) <= 4)>> {
+    using type = std::conditional_t<std::is_signed_v<T>, int64_t, uint64_t>;
+};
+template <typename T>
+struct wide_integer<T, std::enable_if_t<std::is_integral_v<T> && sizeof(T) == 8>> {
+    using type = std::conditional_t<std::is_signed_v<T>, __int128, unsigned __int128>;
+};
+template <>
+struct wide_integer<unsigned __int128> { using type = uint_t<256>; };
+template <unsigned Bits>
+struct wide_integer<uint_t<Bits>> { using type = uint_t<2 * Bits>; };
+template <typename T>
+using wide_integer_t = typename wide_integer<T>::type;
+
+// Unsigned type with the same width as T
+template <typename T, typename = void>
+struct unsigned_integer { using type = T; };
+template <typename T>
+struct unsigned_integer<T, std::enable_if_t<std::is_integral_v<T>>> { using type = std::make_unsigned_t<T>; };
+template <>
+struct unsigned_integer<__int128> { using type = unsigned __int128; };
+template <typename T>
+using unsigned_integer_t = typename unsigned_integer<T>::type;
+
+// Unsigned built-in integers and uint_t<Bits>
+template <typename T>
+inline constexpr bool is_unsigned_integer_v = [] {
+    if constexpr (is_integer_v<T> && !std::is_same_v<T, bool>) {
+        return T(0) < T(-1);
+    } else {
+        return false;
+    }
+}();
+
+namespace detail {
+
+// Trailing zero count for 64-bit, 128-bit and multiword integers (compile-time)
+template <typename T>
+constexpr unsigned countr_zero_wide(T x) {
+    if constexpr (sizeof(T) > 16) {
+        return countr_zero(x);
+    } else if constexpr (sizeof(T) > sizeof(uint64_t)) {
+        const uint64_t low = static_cast<uint64_t>(x);
+        return low != 0 ? std::countr_zero(low) : 64 + std::countr_zero(static_cast<uint64_t>(x >> 64));
+    } else {
+        return std::countr_zero(static_cast<uint64_t>(x));
+    }
+}
+
+// Number of significant bits for 64-bit, 128-bit and multiword integers (compile-time)
+template <typename T>
+constexpr unsigned bit_width_wide(T x) {
+    if constexpr (sizeof(T) > 16) {
+        return bit_width(x);
+    } else if constexpr (sizeof(T) > sizeof(uint64_t)) {
+        const uint64_t high = static_cast<uint64_t>(x >> 64);
+        return high != 0 ? 64 + std::bit_width(high) : std::bit_width(static_cast<uint64_t>(x));
+    } else {
+        return std::bit_width(static_cast<uint64_t>(x));
+    }
+}
+
+// (hi:lo) / d for hi < d, returning the quotient and storing the remainder.
+// Uses a single divq on x86-64 instead of a 128-bit library division.
+constexpr uint64_t div_2by1(uint64_t hi, uint64_t lo, uint64_t d, uint64_t& rem) {
+#if (defined(__x86_64__) || defined(_M_X64)) && defined(__GNUC__)
+    if (!std::is_constant_evaluated()) {
+        uint64_t q;
+        __asm__("divq %4" : "=a"(q), "=d"(rem) : "a"(lo), "d"(hi), "rm"(d));
+        return q;
+    }
+#endif
+    const unsigned __int128 num = (static_cast<unsigned __int128>(hi) << 64) | lo;
+    rem = static_cast<uint64_t>(num % d);
+    return static_cast<uint64_t>(num / d);
+}
+
+// r = a + b over n limbs, returning the carry out
+constexpr uint64_t add_limbs(uint64_t* r, const uint64_t* a, const uint64_t* b, size_t n) {
+#if defined(__x86_64__) || defined(_M_X64)
+    if (!std::is_constant_evaluated()) {
+        unsigned char carry = 0;
+        for (size_t i = 0; i < n; i++) {
+            unsigned long long sum;
+            carry = _addcarry_u64(carry, a[i], b[i], &sum);
+            r[i] = sum;
+        }
+        return carry;
+    }
+#endif
+    uint64_t carry = 0;
+    for (size_t i = 0; i < n; i++) {
+        const uint64_t s = a[i] + carry;
+        const uint64_t c1 = s < carry;
+        const uint64_t sum = s + b[i];
+        carry = c1 | (sum < s);
+        r[i] = sum;
+    }
+    return carry;
+}
+
+// r = a - b over n limbs, returning the borrow out
+constexpr uint64_t sub_limbs(uint64_t* r, const uint64_t* a, const uint64_t* b, size_t n) {
+#if defined(__x86_64__) || defined(_M_X64)
+    if (!std::is_constant_evaluated()) {
+        unsigned char borrow = 0;
+        for (size_t i = 0; i < n; i++) {
+            unsigned long long diff;
+            borrow = _subborrow_u64(borrow, a[i], b[i], &diff);
+            r[i] = diff;
+        }
+        return borrow;
+    }
+#endif
+    uint64_t borrow = 0;
+    for (size_t i = 0; i < n; i++) {
+        const uint64_t d = a[i] - b[i];
+        const uint64_t b1 = a[i] < b[i];
+        r[i] = d - borrow;
+        borrow = b1 | (d < borrow);
+    }
+    return borrow;
+}
+
+// r[0, na + nb) = a[0, na) * b[0, nb); r must not alias a or b
+constexpr void mul_limbs_schoolbook(uint64_t* r, const uint64_t* a, size_t na, const uint64_t* b, size_t nb) {
+    for (size_t i = 0; i < na + nb; i++) r[i] = 0;
+    for (size_t i = 0; i < na; i++) {
+        uint64_t carry = 0;
+        for (size_t j = 0; j < nb; j++) {
+            const unsigned __int128 t = static_cast<unsigned __int128>(a[i]) * b[j] + r[i + j] + carry;
+            r[i + j] = static_cast<uint64_t>(t);
+            carry = static_cast<uint64_t>(t >> 64);
+        }
+        r[i + nb] = carry;
+    }
+}
+
+// Knuth's algorithm D: q = u / v and r = u % v for m = len(u) >= n = len(v)
+// limbs, v[n - 1] != 0 and n >= 2. q gets m - n + 1 limbs, r gets n limbs,
+// and scratch must hold m + n + 1 limbs.
+constexpr void divmod_limbs(const uint64_t* u, size_t m, const uint64_t* v, size_t n,
+                            uint64_t* q, uint64_t* r, uint64_t* scratch) {
+    uint64_t* un = scratch;          // m + 1 limbs
+    uint64_t* vn = scratch + m + 1;  // n limbs
+
+    // Normalize so the top limb of v has its high bit set
+    const unsigned s = std::countl_zero(v[n - 1]);
+    for (size_t i = n - 1; i > 0; i--) {
+        vn[i] = s ? (v[i] << s) | (v[i - 1] >> (64 - s)) : v[i];
+    }
+    vn[0] = v[0] << s;
+    un[m] = s ? u[m - 1] >> (64 - s) : 0;
+    for (size_t i = m - 1; i > 0; i--) {
+        un[i] = s ? (u[i] << s) | (u[i - 1] >> (64 - s)) : u[i];
+    }
+    un[0] = u[0] << s;
+
+    using u128 = unsigned __int128;
+    for (size_t j = m - n + 1; j-- > 0;) {
+        // Estimate the quotient limb from the top two limbs, then correct it
+        const u128 num = (u128(un[j + n]) << 64) | un[j + n - 1];
+        u128 qhat = num / vn[n - 1];
+        u128 rhat = num % vn[n - 1];
+        while ((qhat >> 64) != 0 || qhat * vn[n - 2] > ((rhat << 64) | un[j + n - 2])) {
+            qhat--;
+            rhat += vn[n - 1];
+            if ((rhat >> 64) != 0) break;
+        }
+
+        // Multiply and subtract
+        uint64_t borrow = 0, carry = 0;
+        for (size_t i = 0; i < n; i++) {
+            const u128 p = qhat * vn[i] + carry;
+            carry = static_cast<uint64_t>(p >> 64);
+            const uint64_t lo = static_cast<uint64_t>(p);
+            const uint64_t d = un[i + j] - lo;
+            const uint64_t b1 = un[i + j] < lo;
+            un[i + j] = d - borrow;
+            borrow = b1 | (d < borrow);
+        }
+        const uint64_t top = un[j + n];
+        un[j + n] = top - carry - borrow;
+        const bool negative = top < carry || top - carry < borrow;
+
+        q[j] = static_cast<uint64_t>(qhat);
+        if (negative) {
+            // qhat was one too large: add v back
+            q[j]--;
+            un[j + n] += add_limbs(un + j, un + j, vn, n);
+        }
+    }
+
+    // Unnormalize the remainder
+    for (size_t i = 0; i < n; i++) {
+        r[i] = s ? (un[i] >> s) | (un[i + 1] << (64 - s)) : un[i];
+    }
+}
+
+// Limb count from which multiword products switch to Karatsuba
+inline constexpr size_t karatsuba_limbs = 8;
+
+} // namespace detail
+
+// ===== Fixed-width multiword integers =====
+
+// Unsigned integer of Bits bits with the semantics of the built-in unsigned
+// types (arithmetic mod 2^Bits), usable in constant expressions
+template <unsigned Bits>
+struct uint_t {
+    static_assert(Bits >= 128 && Bits % 64 == 0, "uint_t width must be a multiple of 64 bits, at least 128");
+    static constexpr size_t LIMBS = Bits / 64;
+
+    std::array<uint64_t, LIMBS> limbs{};  // least significant first
+
+    constexpr uint_t() = default;
+
+    // From any built-in integer; negative values wrap like unsigned conversion
+    template <typename U, std::enable_if_t<is_builtin_integer_v<U>, int> = 0>
+    constexpr uint_t(U value) {
+        limbs[0] = static_cast<uint64_t>(value);
+        if constexpr (sizeof(U) > sizeof(uint64_t)) {
+            limbs[1] = static_cast<uint64_t>(value >> 64);
+        }
+        if constexpr (std::is_signed_v<U> || std::is_same_v<U, __int128>) {
+            if (value >= U(0)) return;
+            for (size_t i = sizeof(U) > sizeof(uint64_t) ? 2 : 1; i < LIMBS; i++) limbs[i] = ~uint64_t(0);
+        }
+    }
+
+    // From another width, truncating or zero-extending
+    template <unsigned OtherBits, std::enable_if_t<OtherBits != Bits, int> = 0>
+    constexpr explicit uint_t(const uint_t<OtherBits>& other) {
+        for (size_t i = 0; i < std::min(LIMBS, other.LIMBS); i++) limbs[i] = other.limbs[i];
+    }
+
+    constexpr explicit operator bool() const {
+        for (uint64_t limb : limbs) {
+            if (limb != 0) return true;
+        }
+        return false;
+    }
+
+    // To a built-in integer, truncating
+    template <typename U, std::enable_if_t<is_builtin_integer_v<U> && !std::is_same_v<U, bool>, int> = 0>
+    constexpr explicit operator U() const {
+        if constexpr (sizeof(U) > sizeof(uint64_t)) {
+            return static_cast<U>((static_cast<unsigned __int128>(limbs[1]) << 64) | limbs[0]);
+        } else {
+            return static_cast<U>(limbs[0]);
+        }
+    }
+
+    // Number of limbs up to the most significant non-zero one
+    constexpr size_t used_limbs() const {
+        size_t n = LIMBS;
+        while (n > 0 && limbs[n - 1] == 0) n--;
+        return n;
+    }
+
+    friend constexpr bool operator==(const uint_t& a, const uint_t& b) = default;
+
+    friend constexpr std::strong_ordering operator<=>(const uint_t& a, const uint_t& b) {
+        for (size_t i = LIMBS; i-- > 0;) {
+            if (a.limbs[i] != b.limbs[i]) return a.limbs[i] <=> b.limbs[i];
+        }
+        return std::strong_ordering::equal;
+    }
+
+    friend constexpr uint_t operator+(const uint_t& a, const uint_t& b) {
+        uint_t r;
+        detail::add_limbs(r.limbs.data(), a.limbs.data(), b.limbs.data(), LIMBS);
+        return r;
+    }
+
+    friend constexpr uint_t operator-(const uint_t& a, const uint_t& b) {
+        uint_t r;
+        detail::sub_limbs(r.limbs.data(), a.limbs.data(), b.limbs.data(), LIMBS);
+        return r;
+    }
+
+    constexpr uint_t operator-() const { return uint_t() - *this; }
+    constexpr uint_t operator~() const {
+        uint_t r;
+        for (size_t i = 0; i < LIMBS; i++) r.limbs[i] = ~limbs[i];
+        return r;
+    }
+
+    // Product mod 2^Bits; only limbs below LIMBS are computed
+    friend constexpr uint_t operator*(const uint_t& a, const uint_t& b) {
+        uint_t r;
+        const size_t na = a.used_limbs(), nb = b.used_limbs();
+        for (size_t i = 0; i < na; i++) {
+            uint64_t carry = 0;
+            for (size_t j = 0; j < nb && i + j < LIMBS; j++) {
+                const unsigned __int128 t = static_cast<unsigned __int128>(a.limbs[i]) * b.limbs[j] +
+                                            r.limbs[i + j] + carry;
+                r.limbs[i + j] = static_cast<uint64_t>(t);
+                carry = static_cast<uint64_t>(t >> 64);
+            }
+            if (i + nb < LIMBS) r.limbs[i + nb] = carry;
+        }
+        return r;
+    }
+
+    // Quotient and remainder by a single word
+    friend constexpr std::pair<uint_t, uint64_t> divmod(const uint_t& a, uint64_t d) {
+        uint_t q;
+        uint64_t rem = 0;
+        for (size_t i = a.used_limbs(); i-- > 0;) {
+            q.limbs[i] = detail::div_2by1(rem, a.limbs[i], d, rem);
+        }
+        return {q, rem};
+    }
+
+    // Quotient and remainder; single-word divisors take the fast path
+    friend constexpr std::pair<uint_t, uint_t> divmod(const uint_t& a, const uint_t& b) {
+        const size_t m = a.used_limbs(), n = b.used_limbs();
+        if (n <= 1) {
+            auto [q, rem] = divmod(a, b.limbs[0]);
+            return {q, uint_t(rem)};
+        }
+        if (a < b) return {uint_t(), a};
+
+        uint_t q, r;
+        std::array<uint64_t, 2 * LIMBS + 1> scratch{};
+        detail::divmod_limbs(a.limbs.data(), m, b.limbs.data(), n, q.limbs.data(), r.limbs.data(), scratch.data());
+        return {q, r};
+    }
+
+    friend constexpr uint_t operator/(const uint_t& a, const uint_t& b) { return divmod(a, b).first; }
+    friend constexpr uint_t operator%(const uint_t& a, const uint_t& b) { return divmod(a, b).second; }
+
+    friend constexpr uint_t operator&(const uint_t& a, const uint_t& b) {
+        uint_t r;
+        for (size_t i = 0; i < LIMBS; i++) r.limbs[i] = a.limbs[i] & b.limbs[i];
+        return r;
+    }
+    friend constexpr uint_t operator|(const uint_t& a, const uint_t& b) {
+        uint_t r;
+        for (size_t i = 0; i < LIMBS; i++) r.limbs[i] = a.limbs[i] | b.limbs[i];
+        return r;
+    }
+    friend constexpr uint_t operator^(const uint_t& a, const uint_t& b) {
+        uint_t r;
+        for (size_t i = 0; i < LIMBS; i++) r.limbs[i] = a.limbs[i] ^ b.limbs[i];
+        return r;
+    }
+
+    friend constexpr uint_t operator<<(const uint_t& a, unsigned shift) {
+        uint_t r;
+        if (shift >= Bits) return r;
+        const size_t words = shift / 64;
+        const unsigned bits = shift % 64;
+        for (size_t i = LIMBS; i-- > words;) {
+            r.limbs[i] = a.limbs[i - words] << bits;
+            if (bits && i > words) r.limbs[i] |= a.limbs[i - words - 1] >> (64 - bits);
+        }
+        return r;
+    }
+
+    friend constexpr uint_t operator>>(const uint_t& a, unsigned shift) {
+        uint_t r;
+        if (shift >= Bits) return r;
+        const size_t words = shift / 64;
+        const unsigned bits = shift % 64;
+        for (size_t i = 0; i + words < LIMBS; i++) {
+            r.limbs[i] = a.limbs[i + words] >> bits;
+            if (bits && i + words + 1 < LIMBS) r.limbs[i] |= a.limbs[i + words + 1] << (64 - bits);
+        }
+        return r;
+    }
+
+    constexpr uint_t& operator+=(const uint_t& b) { return *this = *this + b; }
+    constexpr uint_t& operator-=(const uint_t& b) { return *this = *this - b; }
+    constexpr uint_t& operator*=(const uint_t& b) { return *this = *this * b; }
+    constexpr uint_t& operator/=(const uint_t& b) { return *this = *this / b; }
+    constexpr uint_t& operator%=(const uint_t& b) { return *this = *this % b; }
+    constexpr uint_t& operator&=(const uint_t& b) { return *this = *this & b; }
+    constexpr uint_t& operator|=(const uint_t& b) { return *this = *this | b; }
+    constexpr uint_t& operator^=(const uint_t& b) { return *this = *this ^ b; }
+    constexpr uint_t& operator<<=(unsigned shift) { return *this = *this << shift; }
+    constexpr uint_t& operator>>=(unsigned shift) { return *this = *this >> shift; }
+
+    constexpr uint_t& operator++() { return *this += uint_t(1); }
+    constexpr uint_t& operator--() { return *this -= uint_t(1); }
+    constexpr uint_t operator++(int) { uint_t old = *this; ++*this; return old; }
+    constexpr uint_t operator--(int) { uint_t old = *this; --*this; return old; }
+
+    friend constexpr unsigned countr_zero(const uint_t& a) {
+        for (size_t i = 0; i < LIMBS; i++) {
+            if (a.limbs[i] != 0) return static_cast<unsigned>(64 * i) + std::countr_zero(a.limbs[i]);
+        }
+        return Bits;
+    }
+
+    friend constexpr unsigned bit_width(const uint_t& a) {
+        const size_t n = a.used_limbs();
+        return n == 0 ? 0 : static_cast<unsigned>(64 * (n - 1)) + std::bit_width(a.limbs[n - 1]);
+    }
+};
+
+namespace detail {
+
+// Full product of two N-limb numbers: Karatsuba down to the schoolbook
+// threshold, with the carries of the half sums folded back in
+template <size_t N>
+constexpr void mul_limbs_karatsuba(uint64_t* r, const uint64_t* a, const uint64_t* b) {
+    if constexpr (N < karatsuba_limbs || N % 2 != 0) {
+        mul_limbs_schoolbook(r, a, N, b, N);
+    } else {
+        constexpr size_t H = N / 2;
+        std::array<uint64_t, H> sa{}, sb{};
+        const uint64_t ca = add_limbs(sa.data(), a, a + H, H);
+        const uint64_t cb = add_limbs(sb.data(), b, b + H, H);
+
+        // z0 = a0 b0 and z2 = a1 b1 go straight into r
+        mul_limbs_karatsuba<H>(r, a, b);
+        mul_limbs_karatsuba<H>(r + N, a + H, b + H);
+
+        // z1 = (a0 + a1)(b0 + b1) - z0 - z2, N + 1 limbs
+        std::array<uint64_t, N + 1> z1{};
+        mul_limbs_karatsuba<H>(z1.data(), sa.data(), sb.data());
+        if (ca) z1[N] += add_limbs(z1.data() + H, z1.data() + H, sb.data(), H);
+        if (cb) z1[N] += add_limbs(z1.data() + H, z1.data() + H, sa.data(), H);
+        z1[N] += ca & cb;
+        std::array<uint64_t, N + 1> z{};
+        for (size_t i = 0; i < N; i++) z[i] = r[i];
+        z1[N] -= sub_limbs(z1.data(), z1.data(), z.data(), N);
+        for (size_t i = 0; i < N; i++) z[i] = r[N + i];
+        z1[N] -= sub_limbs(z1.data(), z1.data(), z.data(), N);
+
+        // r += z1 << (64 H)
+        uint64_t carry = add_limbs(r + H, r + H, z1.data(), N + 1);
+        for (size_t i = N + H + 1; carry && i < 2 * N; i++) carry = ++r[i] == 0;
+    }
+}
+
+} // namespace detail
+
+// Full double-width product of a and b
+template <typename T>
+constexpr wide_integer_t<T> mul_wide(const T& a, const T& b) {
+    using W = wide_integer_t<T>;
+    if constexpr (is_builtin_integer_v<T>) {
+        return static_cast<W>(a) * static_cast<W>(b);
+    } else {
+        W r;
+        detail::mul_limbs_karatsuba<T::LIMBS>(r.limbs.data(), a.limbs.data(), b.limbs.data());
+        return r;
+    }
+}
+
+// Decimal representation of a 128-bit or multiword integer
+template <typename T>
+std::string to_string(T value) {
+    static_assert(sizeof(T) > sizeof(uint64_t), "Use std::to_string for built-in integers");
+    constexpr uint64_t CHUNK = 10000000000000000000ULL;  // 10^19
+    std::array<char, sizeof(T) * 8 * 3 / 10 + 20> buffer;
+    char* first = buffer.data() + buffer.size();
+    do {
+        uint64_t chunk;
+        if constexpr (is_builtin_integer_v<T>) {
+            chunk = static_cast<uint64_t>(value % CHUNK);
+            value /= CHUNK;
+        } else {
+            auto [q, rem] = divmod(value, CHUNK);
+            chunk = rem;
+            value = q;
+        }
+        // Lower chunks are zero-padded to 19 digits
+        for (int i = 0; i < 19 && (chunk != 0 || value != T(0) || first == buffer.data() + buffer.size()); i++) {
+            *--first = static_cast<char>('0' + chunk % 10);
+            chunk /= 10;
+        }
+    } while (value != T(0));
+    return std::string(first, buffer.data() + buffer.size());
+}
+
 // ===== Compile-time basic number theory functions =====
 
 // Greatest Common Divisor (compile-time)
 template <typename T>
 constexpr T gcd(T a, T b) {
-    static_assert(std::is_integral_v<T>, "Type must be integral");
+    static_assert(is_integer_v<T>, "Type must be integral");
     while (b != 0) {
         T temp = b;
         b = a % b;
@@ -40,14 +566,26 @@ constexpr T gcd(T a, T b) {
 // Least Common Multiple (compile-time)
 template <typename T>
 constexpr T lcm(T a, T b) {
-    static_assert(std::is_integral_v<T>, "Type must be integral");
+    static_assert(is_integer_v<T>, "Type must be integral");
     return (a / gcd(a, b)) * b;
 }
 
+// Overflow-free modular multiplication for 64-bit operands (compile-time)
+constexpr uint64_t mulmod(uint64_t a, uint64_t b, uint64_t m) {
+    return static_cast<uint64_t>(static_cast<unsigned __int128>(a) * b % m);
+}
+
+// Overflow-free modular multiplication through the double-width type (compile-time)
+template <typename T>
+constexpr T mulmod(T a, T b, T m) {
+    static_assert(is_integer_v<T>, "Type must be integral");
+    return static_cast<T>(mul_wide(a, b) % static_cast<wide_integer_t<T>>(m));
+}
+
 // Fast Modular Exponentiation (compile-time)
 template <typename T>
 constexpr T modpow(T base, T exp, T modulus) {
-    static_assert(std::is_integral_v<T>, "Type must be integral");
+    static_assert(is_integer_v<T>, "Type must be integral");
     if (modulus == 1) return 0;
     
     T result = 1;
@@ -55,25 +593,247 @@ constexpr T modpow(T base, T exp, T modulus) {
     
     while (exp > 0) {
         if (exp & 1) {
-            result = (result * base) % modulus;
+            result = mulmod(result, base, modulus);
         }
         exp >>= 1;
-        base = (base * base) % modulus;
+        base = mulmod(base, base, modulus);
     }
     
     return result;
 }
 
+namespace detail {
+
+// Whether r^k <= n, without overflowing (compile-time)
+constexpr bool pow_leq(uint64_t r, unsigned k, uint64_t n) {
+    uint64_t acc = 1;
+    for (unsigned i = 0; i < k; i++) {
+        if (r != 0 && acc > n / r) return false;
+        acc *= r;
+    }
+    return acc <= n;
+}
+
+// Flags for the k-th power residues mod M (compile-time)
+template <uint32_t M, unsigned K>
+inline constexpr auto power_residues = [] {
+    std::array<bool, M> residues{};
+    for (uint64_t x = 0; x < M; x++) {
+        uint64_t y = 1;
+        for (unsigned i = 0; i < K; i++) y = y * x % M;
+        residues[y] = true;
+    }
+    return residues;
+}();
+
+} // namespace detail
+
+// Integer square root floor(sqrt(n)): floating-point seed plus correction
+// at runtime, integer Newton iteration at compile time
+constexpr uint64_t isqrt(uint64_t n) {
+    if (n < 2) return n;
+    if (std::is_constant_evaluated()) {
+        uint64_t x = uint64_t(1) << ((std::bit_width(n) + 1) / 2);
+        for (uint64_t y = (x + n / x) / 2; y < x; y = (x + n / x) / 2) x = y;
+        return x;
+    }
+    uint64_t r = static_cast<uint64_t>(std::sqrt(static_cast<double>(n)));
+    while (r > n / r) r--;
+    while (r + 1 <= n / (r + 1)) r++;
+    return r;
+}
+
+// Integer square root for 128-bit and multiword integers (compile-time)
+template <typename T, std::enable_if_t<is_integer_v<T> && (sizeof(T) > sizeof(uint64_t)), int> = 0>
+constexpr T isqrt(T n) {
+    if (n < 2) return n;
+    T x = T(1) << ((detail::bit_width_wide(n) + 1) / 2);
+    for (T y = (x + n / x) >> 1; y < x; y = (x + n / x) >> 1) x = y;
+    return x;
+}
+
+// Integer k-th root floor(n^(1/k)) for k >= 1 (compile-time)
+constexpr uint64_t iroot(uint64_t n, unsigned k) {
+    if (k == 1 || n < 2) return n;
+    if (k == 2) return isqrt(n);
+    if (k >= 64) return 1;
+    
+    uint64_t r;
+    if (std::is_constant_evaluated()) {
+        // Bitwise search: the root has at most ceil(bits / k) bits
+        r = 0;
+        for (int bit = (std::bit_width(n) + k - 1) / k; bit >= 0; bit--) {
+            const uint64_t candidate = r | (uint64_t(1) << bit);
+            if (detail::pow_leq(candidate, k, n)) r = candidate;
+        }
+        return r;
+    }
+    r = static_cast<uint64_t>(std::pow(static_cast<double>(n), 1.0 / k));
+    while (r > 0 && !detail::pow_leq(r, k, n)) r--;
+    while (detail::pow_leq(r + 1, k, n)) r++;
+    return r;
+}
+
+// Integer cube root floor(cbrt(n)) (compile-time)
+constexpr uint64_t icbrt(uint64_t n) {
+    if (n < 2 || std::is_constant_evaluated()) return iroot(n, 3);
+    uint64_t r = static_cast<uint64_t>(std::cbrt(static_cast<double>(n)));
+    while (r > 0 && !detail::pow_leq(r, 3, n)) r--;
+    while (detail::pow_leq(r + 1, 3, n)) r++;
+    return r;
+}
+
+// Decomposes n = base^exponent with the largest possible exponent >= 2,
+// or returns nullopt if n is not a perfect power (n < 4 never is).
+// Square and cube candidates are screened with residue tables first.
+constexpr std::optional<std::pair<uint64_t, unsigned>> perfect_power(uint64_t n) {
+    if (n < 4) return std::nullopt;
+    
+    // Prime exponents up to log2(n) suffice; composite ones follow by recursion
+    constexpr unsigned prime_exponents[] = {2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37, 41, 43, 47, 53, 59, 61};
+    const unsigned max_exponent = std::bit_width(n) - 1;
+    
+    for (unsigned k : prime_exponents) {
+        if (k > max_exponent) break;
+        if (k == 2 && !(detail::power_residues<64, 2>[n % 64] && detail::power_residues<63, 2>[n % 63] &&
+                        detail::power_residues<65, 2>[n % 65] && detail::power_residues<11, 2>[n % 11])) {
+            continue;
+        }
+        if (k == 3 && !(detail::power_residues<63, 3>[n % 63] && detail::power_residues<13, 3>[n % 13] &&
+                        detail::power_residues<19, 3>[n % 19])) {
+            continue;
+        }
+        
+        // r^k <= n by construction, so r^k <= n - 1 rules out equality
+        const uint64_t r = iroot(n, k);
+        if (detail::pow_leq(r, k, n - 1)) continue;
+        
+        // n = r^k exactly; r itself may be a perfect power
+        if (auto inner = perfect_power(r)) {
+            return std::pair<uint64_t, unsigned>{inner->first, inner->second * k};
+        }
+        return std::pair<uint64_t, unsigned>{r, k};
+    }
+    return std::nullopt;
+}
+
+// Whether n = b^k for some b >= 2 and k >= 2 (compile-time)
+constexpr bool is_perfect_power(uint64_t n) {
+    return perfect_power(n).has_value();
+}
+
+namespace detail {
+
+// Odd primes below 2^10 for trial division, each with its inverse mod 2^64
+// and floor((2^64 - 1) / p): p divides n exactly when n * inverse <= limit,
+// and n * inverse is then the quotient (Granlund and Montgomery). The table
+// is padded to whole 64-byte blocks with entries that divide nothing but 0.
+inline constexpr uint32_t trial_prime_bound = 1 << 10;
+inline constexpr size_t trial_divisor_count = [] {
+    size_t count = 0;
+    for (uint32_t p = 3; p < trial_prime_bound; p += 2) {
+        bool prime = true;
+        for (uint32_t d = 3; d * d <= p && prime; d += 2) prime = p % d != 0;
+        count += prime;
+    }
+    return count;
+}();
+inline constexpr size_t trial_table_size = (trial_divisor_count + 7) / 8 * 8;
+
+struct trial_divisor_table {
+    alignas(64) std::array<uint64_t, trial_table_size> inverse;
+    alignas(64) std::array<uint64_t, trial_table_size> limit;
+    std::array<uint32_t, trial_table_size> prime;
+};
+
+inline constexpr trial_divisor_table trial_table = [] {
+    trial_divisor_table table{};
+    size_t k = 0;
+    for (uint32_t p = 3; p < trial_prime_bound; p += 2) {
+        bool prime = true;
+        for (uint32_t d = 3; d * d <= p && prime; d += 2) prime = p % d != 0;
+        if (!prime) continue;
+        // Newton's iteration doubles the correct low bits from p^-1 = p mod 8
+        uint64_t inverse = p;
+        for (int i = 0; i < 5; i++) inverse *= 2 - p * inverse;
+        table.inverse[k] = inverse;
+        table.limit[k] = UINT64_MAX / p;
+        table.prime[k++] = p;
+    }
+    for (; k < trial_table_size; k++) table.inverse[k] = 1;
+    return table;
+}();
+
+// Index of the first table prime from index k on that divides n > 0, or
+// trial_divisor_count if none does or the next prime's square exceeds n
+// (a block may still report a divisor above sqrt(n)). Tests 8 primes per
+// step with AVX-512, 4 with AVX2.
+inline size_t next_trial_divisor(uint64_t n, size_t k) {
+    const trial_divisor_table& t = trial_table;
+#if defined(__AVX512DQ__)
+    const __m512i nv = _mm512_set1_epi64(static_cast<long long>(n));
+    for (; k % 8 != 0 && k < trial_divisor_count; k++) {
+        if (uint64_t(t.prime[k]) * t.prime[k] > n) return trial_divisor_count;
+        if (n * t.inverse[k] <= t.limit[k]) return k;
+    }
+    for (; k < trial_divisor_count; k += 8) {
+        if (uint64_t(t.prime[k]) * t.prime[k] > n) return trial_divisor_count;
+        const __m512i q = _mm512_mullo_epi64(nv, _mm512_load_si512(t.inverse.data() + k));
+        const __mmask8 hit = _mm512_cmple_epu64_mask(q, _mm512_load_si512(t.limit.data() + k));
+        if (hit != 0) return std::min(k + std::countr_zero(unsigned(hit)), trial_divisor_count);
+    }
+#elif defined(__AVX2__)
+    // 64-bit low products from three 32 x 32 multiplies; unsigned <= as a
+    // signed compare with the sign bits flipped
+    const __m256i nv = _mm256_set1_epi64x(static_cast<long long>(n));
+    const __m256i n_hi = _mm256_srli_epi64(nv, 32);
+    const __m256i sign = _mm256_set1_epi64x(INT64_MIN);
+    for (; k % 4 != 0 && k < trial_divisor_count; k++) {
+        if (uint64_t(t.prime[k]) * t.prime[k] > n) return trial_divisor_count;
+        if (n * t.inverse[k] <= t.limit[k]) return k;
+    }
+    for (; k < trial_divisor_count; k += 4) {
+        if (uint64_t(t.prime[k]) * t.prime[k] > n) return trial_divisor_count;
+        const __m256i inv = _mm256_load_si256(reinterpret_cast<const __m256i*>(t.inverse.data() + k));
+        const __m256i cross = _mm256_add_epi64(_mm256_mul_epu32(n_hi, inv), _mm256_mul_epu32(nv, _mm256_srli_epi64(inv, 32)));
+        const __m256i q = _mm256_add_epi64(_mm256_mul_epu32(nv, inv), _mm256_slli_epi64(cross, 32));
+        const __m256i limit = _mm256_load_si256(reinterpret_cast<const __m256i*>(t.limit.data() + k));
+        const __m256i above = _mm256_cmpgt_epi64(_mm256_xor_si256(q, sign), _mm256_xor_si256(limit, sign));
+        const unsigned hit = ~unsigned(_mm256_movemask_pd(_mm256_castsi256_pd(above))) & 0xF;
+        if (hit != 0) return std::min(k + std::countr_zero(hit), trial_divisor_count);
+    }
+#endif
+    for (; k < trial_divisor_count; k++) {
+        if (uint64_t(t.prime[k]) * t.prime[k] > n) return trial_divisor_count;
+        if (n * t.inverse[k] <= t.limit[k]) return k;
+    }
+    return trial_divisor_count;
+}
+
+} // namespace detail
+
 // Miller-Rabin Primality Test (compile-time for small primes)
 template <typename T>
 constexpr bool is_prime(T n) {
-    static_assert(std::is_integral_v<T>, "Type must be integral");
+    static_assert(is_integer_v<T>, "Type must be integral");
     
     if (n <= 1) return false;
     if (n <= 3) return true;
     if (n % 2 == 0 || n % 3 == 0) return false;
     
-    for (T i = 5; i * i <= n; i += 6) {
+    // At run time the primes below 2^10 are tested by multiplication
+    T start = 5;
+    if constexpr (std::is_integral_v<T> && sizeof(T) <= sizeof(uint64_t)) {
+        if (!std::is_constant_evaluated()) {
+            const uint64_t m = static_cast<uint64_t>(n);
+            const size_t k = detail::next_trial_divisor(m, 0);
+            if (k < detail::trial_divisor_count) return m == detail::trial_table.prime[k];
+            start = T(detail::trial_prime_bound + 1);
+        }
+    }
+    
+    const T limit = static_cast<T>(isqrt(n));
+    for (T i = start; i <= limit; i += 6) {
         if (n % i == 0 || n % (i + 2) == 0) {
             return false;
         }
@@ -85,7 +845,7 @@ constexpr bool is_prime(T n) {
 // Extended Euclidean Algorithm (compile-time)
 template <typename T>
 constexpr std::pair<T, T> extended_gcd(T a, T b) {
-    static_assert(std::is_integral_v<T>, "Type must be integral");
+    static_assert(is_integer_v<T>, "Type must be integral");
     
     if (a == 0) return {0, 1};
     
@@ -96,91 +856,609 @@ constexpr std::pair<T, T> extended_gcd(T a, T b) {
 // Modular multiplicative inverse (compile-time)
 template <typename T>
 constexpr T mod_inverse(T a, T m) {
-    static_assert(std::is_integral_v<T>, "Type must be integral");
+    static_assert(is_integer_v<T>, "Type must be integral");
     auto [x, _] = extended_gcd(a, m);
     return (x % m + m) % m;
 }
 
-// ===== Runtime optimized functions with lock-free concurrency =====
+// ===== Quadratic residue symbols =====
 
-// Thread-safe prime factorization with atomics
+// Jacobi symbol (a/n) for odd n by the binary algorithm: only shifts,
+// subtractions and comparisons, no division (compile-time)
 template <typename T>
-std::vector<T> prime_factors(T n) {
-    static_assert(std::is_integral_v<T>, "Type must be integral");
-    std::vector<T> factors;
-    
-    // Handle small divisors separately
-    while (n % 2 == 0) {
-        factors.push_back(2);
-        n /= 2;
+constexpr int jacobi(T a, T n) {
+    static_assert(is_unsigned_integer_v<T>, "Type must be an unsigned integer");
+    int t = 1;
+    while (a != 0) {
+        // (2/n) = -1 exactly when n = 3 or 5 (mod 8)
+        const unsigned z = detail::countr_zero_wide(a);
+        a >>= z;
+        if ((z & 1) && (((n >> 1) ^ (n >> 2)) & 1)) t = -t;
+        
+        // Quadratic reciprocity flips the sign when a = n = 3 (mod 4)
+        if (a < n) {
+            std::swap(a, n);
+            if ((a & n & 2) != 0) t = -t;
+        }
+        a -= n;
     }
+    return n == 1 ? t : 0;
+}
+
+// Kronecker symbol (a/n) for any signed a and n (compile-time)
+constexpr int kronecker(int64_t a, int64_t n) {
+    if (n == 0) return (a == 1 || a == -1) ? 1 : 0;
     
-    // Use atomics for thread safety in shared contexts
-    std::atomic<T> current_n(n);
-    
-    // Try dividing by odd numbers
-    for (T i = 3; i * i <= current_n.load(); i += 2) {
-        while (current_n.load() % i == 0) {
-            factors.push_back(i);
-            
-            // Atomically update current_n
-            T expected = current_n.load();
-            T desired;
-            do {
-                desired = expected / i;
-            } while (!current_n.compare_exchange_weak(expected, desired));
-        }
+    int t = 1;
+    uint64_t un = static_cast<uint64_t>(n);
+    if (n < 0) {
+        un = 0 - un;
+        if (a < 0) t = -t;
     }
     
-    // If n is a prime number greater than 2
-    if (current_n.load() > 2) {
-        factors.push_back(current_n.load());
+    // (a/2) is 0 for even a and -1 for a = 3 or 5 (mod 8)
+    const unsigned z = std::countr_zero(un);
+    un >>= z;
+    if (z > 0) {
+        if ((a & 1) == 0) return 0;
+        if ((z & 1) && ((a & 7) == 3 || (a & 7) == 5)) t = -t;
     }
     
-    return factors;
+    // (-1/n) = (-1)^((n - 1) / 2) for odd n
+    uint64_t ua = static_cast<uint64_t>(a);
+    if (a < 0) {
+        ua = 0 - ua;
+        if ((un & 3) == 3) t = -t;
+    }
+    return t * jacobi<uint64_t>(ua, un);
 }
 
-// SIMD-accelerated sieve of Eratosthenes - architecture-specific implementation
-std::vector<uint32_t> simd_sieve(uint32_t limit) {
-    if (limit < 2) return {};
+// Jacobi symbols (a[i]/n) for a fixed odd n. Lanes run the binary algorithm
+// in lockstep with branch-free steps, which avoids the mispredicted branches
+// that dominate the scalar loop and lets the compiler vectorize across lanes.
+inline void jacobi_batch(std::span<const uint64_t> a, uint64_t n, std::span<int8_t> out) {
+    constexpr size_t LANES = 8;
+    const size_t count = std::min(a.size(), out.size());
     
-    const size_t size = (limit + 1) / 2; // We only store odd numbers
-    std::vector<bool> is_composite(size, false);
-    std::vector<uint32_t> primes;
-    primes.push_back(2); // Add 2 separately
-    
-    // Process odd numbers
-    for (uint32_t i = 3; i * i <= limit; i += 2) {
-        if (!is_composite[(i - 1) / 2]) {
-            // Mark multiples as composite
-            for (uint32_t j = i * i; j <= limit; j += 2 * i) {
-                is_composite[(j - 1) / 2] = true;
+    for (size_t base = 0; base < count; base += LANES) {
+        const size_t lanes = std::min(LANES, count - base);
+        uint64_t va[LANES] = {}, vn[LANES], sign[LANES] = {};
+        for (size_t l = 0; l < LANES; l++) {
+            va[l] = l < lanes ? a[base + l] : 0;
+            vn[l] = n;
+        }
+        
+        for (bool active = true; active;) {
+            active = false;
+            for (size_t l = 0; l < LANES; l++) {
+                // Strip factors of two from a
+                const uint64_t x = va[l];
+                const uint64_t z = x != 0 ? std::countr_zero(x) : 0;
+                const uint64_t odd = x >> z;
+                sign[l] ^= z & ((vn[l] >> 1) ^ (vn[l] >> 2)) & 1;
+                
+                // (a, n) <- (|a - n|, min(a, n)), flipping on reciprocity
+                const uint64_t swap = odd != 0 && odd < vn[l];
+                sign[l] ^= swap & (odd & vn[l]) >> 1;
+                const uint64_t diff = odd - vn[l];
+                va[l] = odd == 0 ? 0 : (swap ? 0 - diff : diff);
+                vn[l] = swap ? odd : vn[l];
+                active |= va[l] != 0;
             }
         }
+        
+        for (size_t l = 0; l < lanes; l++) {
+            out[base + l] = static_cast<int8_t>(vn[l] != 1 ? 0 : (sign[l] & 1 ? -1 : 1));
+        }
     }
-    
-    // Collect remaining primes
-    for (uint32_t i = 3; i <= limit; i += 2) {
-        if (!is_composite[(i - 1) / 2]) {
-            primes.push_back(i);
+}
+
+// ===== Montgomery arithmetic, Miller-Rabin and Pollard's rho =====
+
+// Montgomery multiplication context for an odd modulus n, R = 2^bits(T).
+// Values passed to mul/add/sub/pow are in Montgomery form (to() / from()).
+template <typename T>
+class montgomery {
+    static_assert(is_unsigned_integer_v<T>, "Montgomery arithmetic needs an unsigned type");
+    static constexpr unsigned BITS = sizeof(T) * 8;
+
+    T n_;
+    T n_inv_;  // n^-1 mod R
+    T r1_;     // R mod n
+    T r2_;     // R^2 mod n
+
+public:
+    constexpr explicit montgomery(T n) : n_(n), n_inv_(n), r1_(), r2_() {
+        // Newton's iteration doubles the number of correct low bits each step
+        for (unsigned bits = 3; bits < BITS; bits *= 2) n_inv_ *= T(2) - n_ * n_inv_;
+        r1_ = (T(0) - n_) % n_;
+        r2_ = mulmod(r1_, r1_, n_);
+    }
+
+    constexpr T modulus() const { return n_; }
+    constexpr T one() const { return r1_; }
+
+    // t / R mod n for t < n R; the low halves of t and m n cancel exactly
+    constexpr T reduce(const wide_integer_t<T>& t) const {
+        const T lo = static_cast<T>(t);
+        const T hi = static_cast<T>(t >> BITS);
+        const T m = lo * n_inv_;
+        const T mn_hi = static_cast<T>(mul_wide(m, n_) >> BITS);
+        return hi >= mn_hi ? hi - mn_hi : hi + (n_ - mn_hi);
+    }
+
+    constexpr T to(const T& a) const { return reduce(mul_wide(T(a % n_), r2_)); }
+    constexpr T from(const T& a) const { return reduce(wide_integer_t<T>(a)); }
+    constexpr T mul(const T& a, const T& b) const { return reduce(mul_wide(a, b)); }
+    constexpr T add(const T& a, const T& b) const { return a >= n_ - b ? a - (n_ - b) : a + b; }
+    constexpr T sub(const T& a, const T& b) const { return a >= b ? a - b : a + (n_ - b); }
+
+    constexpr T pow(T base, T exp) const {
+        T result = r1_;
+        while (exp > 0) {
+            if (exp & 1) result = mul(result, base);
+            exp >>= 1;
+            base = mul(base, base);
         }
+        return result;
     }
-    
-    return primes;
+};
+
+// One Miller-Rabin round: whether odd n > 2 is a strong probable prime to base a
+template <typename T>
+constexpr bool miller_rabin(const montgomery<T>& mont, T a) {
+    const T n = mont.modulus();
+    a %= n;
+    if (a == 0) return true;
+
+    const T n_minus_1 = n - 1;
+    const unsigned s = detail::countr_zero_wide(n_minus_1);
+    const T one = mont.one();
+    const T minus_one = mont.sub(T(0), one);
+
+    T x = mont.pow(mont.to(a), n_minus_1 >> s);
+    if (x == one || x == minus_one) return true;
+    for (unsigned r = 1; r < s; r++) {
+        x = mont.mul(x, x);
+        if (x == minus_one) return true;
+        if (x == one) return false;
+    }
+    return false;
 }
 
-// ===== Coroutine-based number theory functions =====
+namespace detail {
 
-// Generator for Fibonacci sequence using coroutines
-struct fibonacci_generator {
-    struct promise_type {
-        uint64_t value;
-        
-        fibonacci_generator get_return_object() {
-            return {std::coroutine_handle<promise_type>::from_promise(*this)};
+// Strong Lucas probable-prime test with Selfridge's parameters, for odd
+// n > 2 that is not a perfect square and has no small factors
+template <typename T>
+constexpr bool strong_lucas(const montgomery<T>& mont) {
+    const T n = mont.modulus();
+
+    // First D in 5, -7, 9, -11, ... with (D/n) = -1
+    int64_t d = 5;
+    for (;; d = d > 0 ? -(d + 2) : -(d - 2)) {
+        const T abs_d = T(static_cast<uint64_t>(d > 0 ? d : -d));
+        const T d_mod = d > 0 ? abs_d % n : n - abs_d % n;
+        const int j = jacobi<T>(d_mod, n);
+        if (j == -1) break;
+        if (j == 0 && abs_d % n != 0) return false;
+        if (d == 17) {
+            // No such D exists for squares, so rule them out once
+            const T root = isqrt(n);
+            if (root * root == n) return false;
         }
-        
-        std::suspend_always initial_suspend() { return {}; }
+    }
+
+    // P = 1, Q = (1 - D) / 4, all in Montgomery form
+    auto signed_to_mont = [&](int64_t v) {
+        const T magnitude = mont.to(T(static_cast<uint64_t>(v > 0 ? v : -v)));
+        return v >= 0 ? magnitude : mont.sub(T(0), magnitude);
+    };
+    const T D = signed_to_mont(d);
+    const T Q = signed_to_mont((1 - d) / 4);
+    auto halve = [&](T x) { return (x & 1) == 0 ? x >> 1 : (x >> 1) + (n >> 1) + 1; };
+
+    // n + 1 = k 2^s with k odd, computed without overflowing n + 1
+    const T half = (n >> 1) + 1;
+    const unsigned s = 1 + countr_zero_wide(half);
+    const T k = half >> (s - 1);
+
+    // Left-to-right ladder on (U_j, V_j, Q^j) from j = 1
+    T U = mont.one(), V = mont.one(), Qk = Q;
+    for (unsigned bit = bit_width_wide(k) - 1; bit-- > 0;) {
+        U = mont.mul(U, V);
+        V = mont.sub(mont.mul(V, V), mont.add(Qk, Qk));
+        Qk = mont.mul(Qk, Qk);
+        if (((k >> bit) & 1) != 0) {
+            const T U_next = halve(mont.add(U, V));
+            V = halve(mont.add(mont.mul(D, U), V));
+            U = U_next;
+            Qk = mont.mul(Qk, Q);
+        }
+    }
+
+    if (U == 0 || V == 0) return true;
+    for (unsigned r = 1; r < s; r++) {
+        V = mont.sub(mont.mul(V, V), mont.add(Qk, Qk));
+        if (V == 0) return true;
+        Qk = mont.mul(Qk, Qk);
+    }
+    return false;
+}
+
+// Deterministic Miller-Rabin for odd n > 2: these seven bases are exact for
+// every n < 2^64
+constexpr bool miller_rabin_64(uint64_t n) {
+    const montgomery<uint64_t> mont(n);
+    for (uint64_t a : {2ULL, 325ULL, 9375ULL, 28178ULL, 450775ULL, 9780504ULL, 1795265022ULL}) {
+        if (!miller_rabin<uint64_t>(mont, a)) return false;
+    }
+    return true;
+}
+
+} // namespace detail
+
+// Fast primality test. Deterministic Miller-Rabin below 2^64; wider values
+// get the Baillie-PSW test (Miller-Rabin base 2 plus a strong Lucas test),
+// which has no known counterexample.
+template <typename T>
+constexpr bool is_probable_prime(T n) {
+    static_assert(is_integer_v<T>, "Type must be integral");
+    using U = unsigned_integer_t<T>;
+    if (n < 2) return false;
+
+    constexpr uint32_t small_primes[] = {2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37, 41, 43, 47, 53, 59, 61};
+    for (uint32_t p : small_primes) {
+        if (n % T(p) == 0) return n == T(p);
+    }
+    if (n < T(67 * 67)) return true;
+
+    if constexpr (sizeof(U) > sizeof(uint64_t)) {
+        const U un = static_cast<U>(n);
+        if (un <= U(UINT64_MAX)) return is_probable_prime(static_cast<uint64_t>(un));
+        const montgomery<U> mont(un);
+        return miller_rabin(mont, U(2)) && detail::strong_lucas(mont);
+    } else {
+        return detail::miller_rabin_64(static_cast<uint64_t>(n));
+    }
+}
+
+// Pollard's rho in Brent's variant, with gcds batched over 128 steps.
+// Returns a non-trivial factor of an odd composite n that is not a prime power
+// of a tiny prime; n itself is returned only if every attempt fails.
+template <typename T>
+T pollard_rho(T n) {
+    static_assert(is_unsigned_integer_v<T>, "Pollard's rho needs an unsigned type");
+    const montgomery<T> mont(n);
+    constexpr uint64_t BATCH = 128;
+    auto distance = [](const T& a, const T& b) { return a > b ? a - b : b - a; };
+
+    for (uint64_t c = 1; c < 1000; c++) {
+        const T cm = mont.to(T(c));
+        auto f = [&](const T& x) { return mont.add(mont.mul(x, x), cm); };
+
+        T x, ys, y = mont.to(T(2)), q = mont.one(), g = 1;
+        for (uint64_t r = 1; g == 1; r <<= 1) {
+            x = y;
+            for (uint64_t i = 0; i < r; i++) y = f(y);
+            for (uint64_t k = 0; k < r && g == 1; k += BATCH) {
+                ys = y;
+                for (uint64_t i = 0; i < std::min(BATCH, r - k); i++) {
+                    y = f(y);
+                    q = mont.mul(q, distance(x, y));
+                }
+                // Montgomery form only scales q by a unit, so the gcd is unchanged
+                g = gcd(q, n);
+            }
+        }
+
+        // The batch overshot: step back through it one gcd at a time
+        if (g == n) {
+            do {
+                ys = f(ys);
+                g = gcd(distance(x, ys), n);
+            } while (g == 1);
+        }
+        if (g != n) return g;
+    }
+    return n;
+}
+
+// ===== Runtime optimized functions with lock-free concurrency =====
+
+namespace detail {
+
+// Appends the prime factors of n, splitting composites with Pollard's rho
+template <typename Vector, typename U>
+void factor_rho(U n, Vector& factors) {
+    if (n == 1) return;
+    const U d = is_probable_prime(n) ? n : pollard_rho(n);
+    if (d == n) {
+        factors.push_back(static_cast<typename Vector::value_type>(n));
+        return;
+    }
+    factor_rho(d, factors);
+    factor_rho(U(n / d), factors);
+}
+
+} // namespace detail
+
+namespace detail {
+
+// Fixed-capacity vector on the stack
+template <typename T, size_t N>
+struct static_vector {
+    using value_type = T;
+    std::array<T, N> items{};
+    size_t count = 0;
+
+    void push_back(const T& value) { items[count++] = value; }
+    T* begin() { return items.data(); }
+    T* end() { return items.data() + count; }
+};
+
+template <typename A, typename = void>
+struct is_allocator : std::false_type {};
+template <typename A>
+struct is_allocator<A, std::void_t<typename A::value_type, decltype(std::declval<A&>().allocate(size_t(1)))>>
+    : std::true_type {};
+template <typename A>
+inline constexpr bool is_allocator_v = is_allocator<A>::value;
+
+// The memory resource behind a polymorphic allocator, for scratch buffers
+// that should come from the same arena as the result; nullptr otherwise
+template <typename A>
+std::pmr::memory_resource* memory_resource_of(const A& alloc) {
+    if constexpr (std::is_convertible_v<A, std::pmr::polymorphic_allocator<std::byte>>) {
+        return alloc.resource();
+    } else {
+        return nullptr;
+    }
+}
+
+} // namespace detail
+
+namespace detail {
+
+// Divides the odd primes below 2^10 out of n > 0, writing them ascending to
+// out; by multiplication with the table inverses once n fits in 64 bits
+template <typename T, typename OutputIt>
+OutputIt strip_trial_divisors(T& n, OutputIt out) {
+    size_t k = 0;
+    if constexpr (!(std::is_integral_v<T> && sizeof(T) <= sizeof(uint64_t))) {
+        for (; k < trial_divisor_count && n > T(UINT64_MAX); k++) {
+            const T p = T(trial_table.prime[k]);
+            while (n % p == 0) {
+                *out++ = p;
+                n /= p;
+            }
+        }
+        if (n > T(UINT64_MAX)) return out;
+    }
+    uint64_t m = static_cast<uint64_t>(n);
+    while ((k = next_trial_divisor(m, k)) < trial_divisor_count) {
+        const uint64_t inverse = trial_table.inverse[k], limit = trial_table.limit[k];
+        do {
+            *out++ = T(trial_table.prime[k]);
+            m *= inverse;
+        } while (m * inverse <= limit);
+        k++;
+    }
+    n = T(m);
+    return out;
+}
+
+} // namespace detail
+
+// Thread-safe prime factorization (no shared state): trial division by the
+// primes below 2^10, then Miller-Rabin and Pollard's rho on the remaining cofactor.
+// Writes the factors of n >= 1 ascending, with multiplicity, to out without
+// allocating, and returns the end of the output.
+template <typename T, typename OutputIt, std::enable_if_t<!detail::is_allocator_v<OutputIt>, int> = 0>
+OutputIt prime_factors(T n, OutputIt out) {
+    static_assert(is_integer_v<T>, "Type must be integral");
+    constexpr uint32_t TRIAL_LIMIT = detail::trial_prime_bound;
+    if (n == 0) return out;
+    
+    // Handle small divisors separately
+    while (n % 2 == 0) {
+        *out++ = T(2);
+        n /= 2;
+    }
+    
+    out = detail::strip_trial_divisors(n, out);
+    
+    // If n is a prime number greater than 2, or a product of large primes
+    // (each above TRIAL_LIMIT = 2^10, so at most one per 10 bits of n)
+    if (n > 2) {
+        if (isqrt(n) <= TRIAL_LIMIT) {
+            *out++ = n;
+        } else {
+            detail::static_vector<T, sizeof(T) * 8 / 10 + 1> large;
+            detail::factor_rho(static_cast<unsigned_integer_t<T>>(n), large);
+            for (size_t i = 1; i < large.count; i++) {
+                for (size_t j = i; j > 0 && large.items[j] < large.items[j - 1]; j--) std::swap(large.items[j], large.items[j - 1]);
+            }
+            out = std::copy(large.begin(), large.end(), out);
+        }
+    }
+    
+    return out;
+}
+
+// Prime factors of n as a vector from alloc
+template <typename T, typename Alloc = std::allocator<T>, std::enable_if_t<detail::is_allocator_v<Alloc>, int> = 0>
+std::vector<T, Alloc> prime_factors(T n, const Alloc& alloc = Alloc()) {
+    std::vector<T, Alloc> factors(alloc);
+    prime_factors(n, std::back_inserter(factors));
+    return factors;
+}
+
+// Euler's totient, from the prime factorization (phi(0) is taken as 0)
+template <typename T>
+T euler_phi(T n) {
+    static_assert(is_integer_v<T>, "Type must be integral");
+    if (n == 0) return 0;
+    T result = n, last = 0;
+    for (const T& p : prime_factors(n)) {
+        if (p != last) result -= result / p;
+        last = p;
+    }
+    return result;
+}
+
+namespace detail {
+
+// Bit array for the sieves: 64-bit words, 64-byte aligned and padded to whole
+// 512-bit blocks (one cache line, one AVX-512 register), so word and block
+// loops need no tail handling and vectorize on aligned loads. Bits past
+// size() are kept zero. Storage comes from the given memory resource, such as
+// a hugepage_arena, or from aligned operator new.
+class bit_array {
+public:
+    static constexpr size_t BLOCK_WORDS = 8;
+
+    bit_array() = default;
+    explicit bit_array(size_t bits, bool value = false, std::pmr::memory_resource* resource = nullptr)
+        : resource_(resource) {
+        assign(bits, value);
+    }
+    bit_array(const bit_array& other) : resource_(other.resource_) {
+        assign(other.bits_, false);
+        std::copy_n(other.words_, padded_words(), words_);
+    }
+    bit_array(bit_array&& other) noexcept
+        : words_(std::exchange(other.words_, nullptr)), bits_(std::exchange(other.bits_, 0)),
+          capacity_(std::exchange(other.capacity_, 0)), resource_(other.resource_) {}
+    bit_array& operator=(bit_array other) noexcept {
+        std::swap(words_, other.words_);
+        std::swap(bits_, other.bits_);
+        std::swap(capacity_, other.capacity_);
+        std::swap(resource_, other.resource_);
+        return *this;
+    }
+    ~bit_array() { release(); }
+
+    // Resizes to bits, all equal to value; the storage is reused when it fits
+    void assign(size_t bits, bool value) {
+        const size_t words = (bits + 511) / 512 * BLOCK_WORDS;
+        if (words > capacity_) {
+            release();
+            words_ = static_cast<uint64_t*>(resource_ != nullptr ? resource_->allocate(words * sizeof(uint64_t), 64)
+                                                                 : ::operator new(words * sizeof(uint64_t), std::align_val_t(64)));
+            capacity_ = words;
+        }
+        bits_ = bits;
+        std::fill_n(words_, words, value ? ~uint64_t(0) : 0);
+        clear_tail();
+    }
+
+    size_t size() const { return bits_; }
+    size_t word_count() const { return (bits_ + 63) / 64; }
+    size_t block_count() const { return padded_words() / BLOCK_WORDS; }
+
+    bool test(size_t i) const { return (words_[i / 64] >> (i % 64)) & 1; }
+    void set(size_t i) { words_[i / 64] |= uint64_t(1) << (i % 64); }
+    void reset(size_t i) { words_[i / 64] &= ~(uint64_t(1) << (i % 64)); }
+
+    uint64_t* words() { return std::assume_aligned<64>(words_); }
+    const uint64_t* words() const { return std::assume_aligned<64>(words_); }
+    std::span<uint64_t, BLOCK_WORDS> block(size_t b) { return std::span<uint64_t, BLOCK_WORDS>(words() + b * BLOCK_WORDS, BLOCK_WORDS); }
+    std::span<const uint64_t, BLOCK_WORDS> block(size_t b) const {
+        return std::span<const uint64_t, BLOCK_WORDS>(words() + b * BLOCK_WORDS, BLOCK_WORDS);
+    }
+
+    // Zeroes the bits past size() after writing whole words
+    void clear_tail() {
+        if (bits_ % 64) words_[bits_ / 64] &= (uint64_t(1) << (bits_ % 64)) - 1;
+        std::fill(words_ + word_count(), words_ + padded_words(), 0);
+    }
+
+    // Set bits, over whole blocks
+    size_t count() const {
+        const uint64_t* w = words();
+        size_t total = 0;
+        for (size_t i = 0; i < padded_words(); i++) total += std::popcount(w[i]);
+        return total;
+    }
+
+    // Index of the first set bit at or after i, or size() if there is none
+    size_t find_next(size_t i) const {
+        if (i >= bits_) return bits_;
+        size_t w = i / 64;
+        uint64_t word = words_[w] & (~uint64_t(0) << (i % 64));
+        while (word == 0) {
+            if (++w == word_count()) return bits_;
+            word = words_[w];
+        }
+        return 64 * w + std::countr_zero(word);
+    }
+
+private:
+    uint64_t* words_ = nullptr;
+    size_t bits_ = 0;
+    size_t capacity_ = 0;  // in words
+    std::pmr::memory_resource* resource_ = nullptr;
+
+    size_t padded_words() const { return (bits_ + 511) / 512 * BLOCK_WORDS; }
+
+    void release() {
+        if (words_ != nullptr && resource_ != nullptr) resource_->deallocate(words_, capacity_ * sizeof(uint64_t), 64);
+        else if (words_ != nullptr) ::operator delete(words_, std::align_val_t(64));
+        words_ = nullptr;
+        capacity_ = 0;
+    }
+};
+
+} // namespace detail
+
+// SIMD-accelerated sieve of Eratosthenes - architecture-specific implementation
+template <typename Alloc = std::allocator<uint32_t>>
+std::vector<uint32_t, Alloc> simd_sieve(uint32_t limit, const Alloc& alloc = Alloc()) {
+    std::vector<uint32_t, Alloc> primes(alloc);
+    if (limit < 2) return primes;
+    
+    const size_t size = (uint64_t(limit) + 1) / 2; // We only store odd numbers: bit i is 2i + 1
+    detail::bit_array is_composite(size, false, detail::memory_resource_of(alloc));
+    primes.push_back(2); // Add 2 separately
+    
+    // Process odd numbers (64-bit multiples so limits near 2^32 cannot wrap)
+    const uint32_t root = static_cast<uint32_t>(isqrt(limit));
+    for (uint32_t i = 3; i <= root; i += 2) {
+        if (!is_composite.test(i / 2)) {
+            // Mark multiples as composite
+            for (uint64_t j = uint64_t(i) * i; j <= limit; j += 2 * i) {
+                is_composite.set(j / 2);
+            }
+        }
+    }
+    
+    // Collect remaining primes a word at a time (1 is not prime)
+    is_composite.set(0);
+    const uint64_t* words = is_composite.words();
+    for (size_t w = 0; w < is_composite.word_count(); w++) {
+        uint64_t bits = ~words[w];
+        if (64 * (w + 1) > size) bits &= (uint64_t(1) << (size - 64 * w)) - 1;
+        for (; bits != 0; bits &= bits - 1) {
+            primes.push_back(static_cast<uint32_t>(2 * (64 * w + std::countr_zero(bits)) + 1));
+        }
+    }
+    
+    return primes;
+}
+
+// ===== Coroutine-based number theory functions =====
+
+// Generator for Fibonacci sequence using coroutines
+struct fibonacci_generator {
+    struct promise_type {
+        uint64_t value;
+        
+        fibonacci_generator get_return_object() {
+            return {std::coroutine_handle<promise_type>::from_promise(*this)};
+        }
+        
+        std::suspend_always initial_suspend() { return {}; }
         std::suspend_always final_suspend() noexcept { return {}; }
         std::suspend_always yield_value(uint64_t val) {
             value = val;
@@ -257,7 +1535,8 @@ prime_generator generate_primes(uint64_t max_count) {
     while (count < max_count) {
         bool is_prime = true;
         
-        for (uint64_t i = 3; i * i <= num; i += 2) {
+        const uint64_t root = isqrt(num);
+        for (uint64_t i = 3; i <= root; i += 2) {
             if (num % i == 0) {
                 is_prime = false;
                 break;
@@ -273,38 +1552,156 @@ prime_generator generate_primes(uint64_t max_count) {
     }
 }
 
+// Generator of (prime, exponent) pairs
+template <typename T>
+struct factor_generator {
+    struct promise_type {
+        std::pair<T, unsigned> value;
+        
+        factor_generator get_return_object() {
+            return {std::coroutine_handle<promise_type>::from_promise(*this)};
+        }
+        
+        std::suspend_always initial_suspend() { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+        std::suspend_always yield_value(std::pair<T, unsigned> factor) {
+            value = factor;
+            return {};
+        }
+        void unhandled_exception() { std::terminate(); }
+        void return_void() {}
+    };
+    
+    std::coroutine_handle<promise_type> handle;
+    
+    factor_generator(std::coroutine_handle<promise_type> h) : handle(h) {}
+    factor_generator(factor_generator&& other) noexcept : handle(std::exchange(other.handle, {})) {}
+    ~factor_generator() { if (handle) handle.destroy(); }
+    
+    std::pair<T, unsigned> next() {
+        handle.resume();
+        return handle.promise().value;
+    }
+    
+    bool done() const { return handle.done(); }
+};
+
+// Coroutine yielding the prime factorization of n as (prime, exponent)
+// pairs, each prime once, cheapest tier first: powers of two, the primes
+// below 2^10 ascending (division-free), then a prime cofactor, perfect
+// powers and Pollard's rho in the order they split out. A consumer that
+// only needs the smallest factor, or a factor below a bound, stops early
+// and never pays for the later tiers.
+template <typename T>
+factor_generator<T> factor_stream(T n) {
+    static_assert(is_integer_v<T>, "Type must be integral");
+    using U = unsigned_integer_t<T>;
+    if (n <= 1) co_return;
+    U m = static_cast<U>(n);
+    
+    unsigned twos = 0;
+    for (; m % 2 == 0; m /= 2) twos++;
+    if (twos > 0) co_yield {T(2), twos};
+    
+    // Small primes; values wider than 64 bits by division until they fit
+    size_t k = 0;
+    if constexpr (!(std::is_integral_v<U> && sizeof(U) <= sizeof(uint64_t))) {
+        for (; k < detail::trial_divisor_count && m > U(UINT64_MAX); k++) {
+            const U p = U(detail::trial_table.prime[k]);
+            unsigned e = 0;
+            for (; m % p == 0; m /= p) e++;
+            if (e > 0) co_yield {T(p), e};
+        }
+    }
+    if (m <= U(UINT64_MAX)) {
+        uint64_t r = static_cast<uint64_t>(m);
+        while ((k = detail::next_trial_divisor(r, k)) < detail::trial_divisor_count) {
+            const uint64_t inverse = detail::trial_table.inverse[k], limit = detail::trial_table.limit[k];
+            unsigned e = 0;
+            do {
+                r *= inverse;
+                e++;
+            } while (r * inverse <= limit);
+            co_yield {T(detail::trial_table.prime[k]), e};
+            k++;
+        }
+        m = U(r);
+    }
+    if (m == 1) co_return;
+    
+    // No factor below 2^10 remains, so below 2^20 the cofactor is prime
+    if (m / detail::trial_prime_bound < detail::trial_prime_bound || is_probable_prime(m)) {
+        co_yield {T(m), 1u};
+        co_return;
+    }
+    
+    // Split composites (at most one part per 10 bits) until a part is prime,
+    // then count that prime across the other parts
+    detail::static_vector<U, sizeof(U) * 8 / 10 + 1> parts;
+    parts.push_back(m);
+    while (parts.count > 0) {
+        const U c = parts.items[--parts.count];
+        if (c == 1) continue;
+        if (!is_probable_prime(c)) {
+            if constexpr (std::is_integral_v<U> && sizeof(U) <= sizeof(uint64_t)) {
+                if (const auto power = perfect_power(static_cast<uint64_t>(c))) {
+                    for (unsigned i = 0; i < power->second; i++) parts.push_back(U(power->first));
+                    continue;
+                }
+            }
+            const U d = pollard_rho(c);
+            if (d != c) {
+                parts.push_back(U(c / d));
+                parts.push_back(d);
+                continue;
+            }
+        }
+        unsigned e = 1;
+        for (U& part : parts) {
+            for (; part % c == 0; part /= c) e++;
+        }
+        co_yield {T(c), e};
+    }
+}
+
 // ===== Thread-local cache for optimizing repeated calculations =====
 
 // Prime checker with thread-local cache
 class PrimeChecker {
 private:
-    // Thread-local cache of recently checked numbers
-    static thread_local std::vector<std::pair<uint64_t, bool>> cache;
     static constexpr size_t CACHE_SIZE = 1000;
     
+    // Thread-local ring of recently checked numbers. It lives inline in
+    // thread storage, so it never allocates and outlives any caller's arena.
+    struct cache_ring {
+        std::array<std::pair<uint64_t, bool>, CACHE_SIZE> entries;
+        size_t size = 0;
+        size_t next = 0;  // slot to overwrite once full
+    };
+    static thread_local cache_ring cache;
+    
 public:
     static bool is_prime_cached(uint64_t n) {
         // Check cache first
-        for (const auto& entry : cache) {
-            if (entry.first == n) {
-                return entry.second;
+        for (size_t i = 0; i < cache.size; i++) {
+            if (cache.entries[i].first == n) {
+                return cache.entries[i].second;
             }
         }
         
         // Compute result
         bool result = is_prime(n);
         
-        // Update cache
-        if (cache.size() >= CACHE_SIZE) {
-            cache.erase(cache.begin());
-        }
-        cache.emplace_back(n, result);
+        // Update cache, evicting the oldest entry
+        cache.entries[cache.next] = {n, result};
+        cache.next = (cache.next + 1) % CACHE_SIZE;
+        cache.size = std::min(cache.size + 1, CACHE_SIZE);
         
         return result;
     }
 };
 
-thread_local std::vector<std::pair<uint64_t, bool>> PrimeChecker::cache;
+thread_local PrimeChecker::cache_ring PrimeChecker::cache;
 
 // ===== Lock-free concurrent prime counter =====
 
@@ -348,4 +1745,4036 @@ public:
     }
 };
 
+// ===== Number-theoretic transform =====
+
+// Primitive root of a prime modulus (compile-time)
+constexpr uint32_t primitive_root(uint32_t p) {
+    if (p == 2) return 1;
+    uint32_t factors[32] = {};
+    uint32_t count = 0;
+    uint32_t m = p - 1;
+    for (uint64_t q = 2; q * q <= m; q++) {
+        if (m % q == 0) {
+            factors[count++] = static_cast<uint32_t>(q);
+            while (m % q == 0) m /= q;
+        }
+    }
+    if (m > 1) factors[count++] = m;
+
+    for (uint64_t g = 2; g < p; g++) {
+        bool ok = true;
+        for (uint32_t i = 0; i < count && ok; i++) {
+            ok = modpow<uint64_t>(g, (p - 1) / factors[i], p) != 1;
+        }
+        if (ok) return static_cast<uint32_t>(g);
+    }
+    return 0;
+}
+
+// Constants for an NTT-friendly prime P = c * 2^k + 1
+template <uint32_t P>
+struct ntt_prime {
+    static_assert(P > 2 && (P & 1), "NTT modulus must be an odd prime");
+    static constexpr uint32_t root = primitive_root(P);
+    static constexpr unsigned max_log = std::countr_zero(P - 1);
+};
+
+namespace detail {
+
+// Twiddle tables for ntt<P>: entries [h, 2h) hold the powers of a primitive
+// (2h)-th root of unity, each with Shoup's quotient floor(w 2^32 / P) so
+// butterflies multiply without a division. One immutable table per prime
+// and direction is shared by all threads; a longer transform swaps in a
+// larger one, and callers keep the table they were handed alive.
+struct ntt_twiddle_table {
+    std::vector<uint32_t> w, w_shoup;
+};
+
+template <uint32_t P>
+std::shared_ptr<const ntt_twiddle_table> ntt_twiddles(size_t n, bool invert) {
+    static_assert(P < (1u << 31), "NTT modulus must fit in 31 bits");
+    static std::mutex mutex;
+    static std::shared_ptr<const ntt_twiddle_table> tables[2];
+    std::lock_guard<std::mutex> lock(mutex);
+    if (tables[invert] != nullptr && tables[invert]->w.size() >= n) return tables[invert];
+
+    auto t = std::make_shared<ntt_twiddle_table>();
+    t->w.assign(n, 0);
+    t->w_shoup.assign(n, 0);
+    for (size_t half = 1; half < n; half <<= 1) {
+        uint64_t root = modpow<uint64_t>(ntt_prime<P>::root, (P - 1) / (2 * half), P);
+        if (invert) root = modpow<uint64_t>(root, P - 2, P);
+        uint64_t power = 1;
+        for (size_t k = 0; k < half; k++) {
+            t->w[half + k] = static_cast<uint32_t>(power);
+            t->w_shoup[half + k] = static_cast<uint32_t>((power << 32) / P);
+            power = power * root % P;
+        }
+    }
+    tables[invert] = std::move(t);
+    return tables[invert];
+}
+
+} // namespace detail
+
+// In-place iterative radix-2 NTT; a.size() must be a power of two no
+// larger than 2^ntt_prime<P>::max_log
+template <uint32_t P = 998244353>
+void ntt(std::vector<uint32_t>& a, bool invert) {
+    const size_t n = a.size();
+    if (n <= 1) return;
+    assert(std::has_single_bit(n) && n <= (size_t(1) << ntt_prime<P>::max_log));
+
+    // Bit-reversal permutation
+    for (size_t i = 1, j = 0; i < n; i++) {
+        size_t bit = n >> 1;
+        for (; j & bit; bit >>= 1) j ^= bit;
+        j ^= bit;
+        if (i < j) std::swap(a[i], a[j]);
+    }
+
+    const auto tw = detail::ntt_twiddles<P>(n, invert);
+    uint32_t* data = a.data();
+    for (size_t half = 1; half < n; half <<= 1) {
+        const uint32_t* w = tw->w.data() + half;
+        const uint32_t* w_shoup = tw->w_shoup.data() + half;
+        for (size_t i = 0; i < n; i += 2 * half) {
+            uint32_t* lo = data + i;
+            uint32_t* hi = data + i + half;
+            for (size_t k = 0; k < half; k++) {
+                const uint32_t u = lo[k], x = hi[k];
+                const uint32_t q = static_cast<uint32_t>((uint64_t(x) * w_shoup[k]) >> 32);
+                uint32_t v = x * w[k] - q * P;  // in [0, 2P), exact mod 2^32
+                v = v >= P ? v - P : v;
+                lo[k] = u + v >= P ? u + v - P : u + v;
+                hi[k] = u >= v ? u - v : u + P - v;
+            }
+        }
+    }
+
+    if (invert) {
+        uint64_t n_inv = modpow<uint64_t>(n % P, P - 2, P);
+        for (auto& x : a) x = static_cast<uint32_t>(x * n_inv % P);
+    }
+}
+
+// Polynomial product mod P, schoolbook for small inputs
+template <uint32_t P = 998244353>
+std::vector<uint32_t> ntt_multiply(std::vector<uint32_t> a, std::vector<uint32_t> b) {
+    if (a.empty() || b.empty()) return {};
+    const size_t result_size = a.size() + b.size() - 1;
+
+    if (std::min(a.size(), b.size()) <= 32) {
+        std::vector<uint32_t> result(result_size, 0);
+        for (size_t i = 0; i < a.size(); i++) {
+            for (size_t j = 0; j < b.size(); j++) {
+                result[i + j] = static_cast<uint32_t>((result[i + j] + uint64_t(a[i]) * b[j]) % P);
+            }
+        }
+        return result;
+    }
+
+    const size_t n = std::bit_ceil(result_size);
+    a.resize(n);
+    b.resize(n);
+    ntt<P>(a, false);
+    ntt<P>(b, false);
+    for (size_t i = 0; i < n; i++) {
+        a[i] = static_cast<uint32_t>(uint64_t(a[i]) * b[i] % P);
+    }
+    ntt<P>(a, true);
+    a.resize(result_size);
+    return a;
+}
+
+// Power series inverse 1/a mod (x^n, P) by Newton iteration; requires a[0] != 0
+template <uint32_t P = 998244353>
+std::vector<uint32_t> ntt_inverse_series(const std::vector<uint32_t>& a, size_t n) {
+    std::vector<uint32_t> b{static_cast<uint32_t>(modpow<uint64_t>(a[0], P - 2, P))};
+
+    for (size_t len = 1; len < n; len <<= 1) {
+        // b <- b * (2 - a * b) mod x^(2 len)
+        std::vector<uint32_t> a_cut(a.begin(), a.begin() + std::min(a.size(), 2 * len));
+        auto ab = ntt_multiply<P>(std::move(a_cut), b);
+        ab.resize(2 * len);
+        for (auto& x : ab) x = x == 0 ? 0 : P - x;
+        ab[0] = (ab[0] + 2) % P;
+        b = ntt_multiply<P>(std::move(ab), b);
+        b.resize(2 * len);
+    }
+
+    b.resize(n);
+    return b;
+}
+
+namespace detail {
+
+// Longest operands convolve_exact takes: with both within 2^22, |a| + |b|
+// stays within 2^23, the longest transform mod 998244353
+inline constexpr size_t convolve_exact_max_terms = size_t(1) << 22;
+
+// Exact convolution of 32-bit sequences through three NTT primes, recombined
+// with Garner's algorithm. Every term is below 2^64 min(|a|, |b|), which
+// P1 P2 P3 ~ 2^86 covers up to 2^22 terms; |a| + |b| must stay within 2^23.
+inline std::vector<unsigned __int128> convolve_exact(const std::vector<uint32_t>& a, const std::vector<uint32_t>& b) {
+    constexpr uint32_t P1 = 998244353, P2 = 167772161, P3 = 469762049;
+    if (a.empty() || b.empty()) return {};
+    const size_t size = a.size() + b.size() - 1;
+    assert(size < 2 * convolve_exact_max_terms);
+    const size_t n = std::bit_ceil(size);
+
+    auto convolve = [&](auto prime) {
+        constexpr uint32_t P = decltype(prime)::value;
+        std::vector<uint32_t> fa(n, 0), fb(n, 0);
+        for (size_t i = 0; i < a.size(); i++) fa[i] = a[i] % P;
+        for (size_t i = 0; i < b.size(); i++) fb[i] = b[i] % P;
+        ntt<P>(fa, false);
+        ntt<P>(fb, false);
+        for (size_t i = 0; i < n; i++) fa[i] = static_cast<uint32_t>(uint64_t(fa[i]) * fb[i] % P);
+        ntt<P>(fa, true);
+        return fa;
+    };
+    const auto c1 = convolve(std::integral_constant<uint32_t, P1>{});
+    const auto c2 = convolve(std::integral_constant<uint32_t, P2>{});
+    const auto c3 = convolve(std::integral_constant<uint32_t, P3>{});
+
+    constexpr uint64_t P1_INV_MOD_P2 = modpow<uint64_t>(P1, P2 - 2, P2);
+    constexpr uint64_t P12_INV_MOD_P3 = modpow<uint64_t>(uint64_t(P1) * P2 % P3, P3 - 2, P3);
+    std::vector<unsigned __int128> r(size);
+    for (size_t i = 0; i < size; i++) {
+        const uint64_t t1 = (c2[i] + P2 - c1[i] % P2) % P2 * P1_INV_MOD_P2 % P2;
+        const uint64_t x12 = c1[i] + uint64_t(P1) * t1;  // < P1 P2 < 2^58
+        const uint64_t t2 = (c3[i] + P3 - x12 % P3) % P3 * P12_INV_MOD_P3 % P3;
+        r[i] = x12 + static_cast<unsigned __int128>(uint64_t(P1) * P2) * t2;
+    }
+    return r;
+}
+
+} // namespace detail
+
+// ===== Arbitrary-precision integers =====
+
+namespace detail {
+
+// Limb counts (of the shorter operand) at which big_uint multiplication moves
+// up the ladder. Measured with `make benchmark`; see bench_big_multiplication.
+inline constexpr size_t big_karatsuba_limbs = 32;
+inline constexpr size_t big_toom3_limbs = 1024;
+inline constexpr size_t big_ntt_limbs = 6000;
+
+// Limb storage with a small inline buffer; larger numbers are allocated
+// through Alloc, so a whole computation can live in a caller's arena
+template <typename Alloc>
+class limb_vector {
+    using traits = std::allocator_traits<Alloc>;
+    static constexpr size_t INLINE_LIMBS = 4;
+
+    [[no_unique_address]] Alloc alloc_;
+    uint64_t* data_;
+    size_t size_ = 0;
+    size_t capacity_ = INLINE_LIMBS;
+    uint64_t inline_[INLINE_LIMBS];
+
+    bool is_inline() const { return data_ == inline_; }
+
+    void release() {
+        if (!is_inline()) traits::deallocate(alloc_, data_, capacity_);
+        data_ = inline_;
+        capacity_ = INLINE_LIMBS;
+    }
+
+    void steal(limb_vector& other) {
+        if (other.is_inline()) {
+            std::copy(other.inline_, other.inline_ + other.size_, inline_);
+        } else {
+            data_ = other.data_;
+            capacity_ = other.capacity_;
+            other.data_ = other.inline_;
+            other.capacity_ = INLINE_LIMBS;
+        }
+        size_ = std::exchange(other.size_, 0);
+    }
+
+public:
+    explicit limb_vector(const Alloc& alloc = Alloc()) : alloc_(alloc), data_(inline_) {}
+    limb_vector(const limb_vector& other)
+        : alloc_(traits::select_on_container_copy_construction(other.alloc_)), data_(inline_) {
+        assign(other.data_, other.size_);
+    }
+    limb_vector(limb_vector&& other) noexcept : alloc_(std::move(other.alloc_)), data_(inline_) {
+        steal(other);
+    }
+    ~limb_vector() { release(); }
+
+    limb_vector& operator=(const limb_vector& other) {
+        if (this == &other) return *this;
+        if constexpr (traits::propagate_on_container_copy_assignment::value) {
+            release();
+            alloc_ = other.alloc_;
+        }
+        assign(other.data_, other.size_);
+        return *this;
+    }
+
+    limb_vector& operator=(limb_vector&& other) noexcept(traits::propagate_on_container_move_assignment::value ||
+                                                         traits::is_always_equal::value) {
+        if (this == &other) return *this;
+        if constexpr (traits::propagate_on_container_move_assignment::value) {
+            release();
+            alloc_ = std::move(other.alloc_);
+            steal(other);
+        } else if (alloc_ == other.alloc_) {
+            release();
+            steal(other);
+        } else {
+            assign(other.data_, other.size_);
+        }
+        return *this;
+    }
+
+    Alloc get_allocator() const { return alloc_; }
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    uint64_t* data() { return data_; }
+    const uint64_t* data() const { return data_; }
+    uint64_t& operator[](size_t i) { return data_[i]; }
+    const uint64_t& operator[](size_t i) const { return data_[i]; }
+    uint64_t& back() { return data_[size_ - 1]; }
+    const uint64_t& back() const { return data_[size_ - 1]; }
+
+    void reserve(size_t n) {
+        if (n <= capacity_) return;
+        const size_t new_capacity = std::max(n, 2 * capacity_);
+        uint64_t* p = traits::allocate(alloc_, new_capacity);
+        std::copy(data_, data_ + size_, p);
+        release();
+        data_ = p;
+        capacity_ = new_capacity;
+    }
+
+    // Grows with zero limbs or shrinks
+    void resize(size_t n) {
+        reserve(n);
+        if (n > size_) std::fill(data_ + size_, data_ + n, 0);
+        size_ = n;
+    }
+
+    void assign(const uint64_t* src, size_t n) {
+        reserve(n);
+        std::copy(src, src + n, data_);
+        size_ = n;
+    }
+
+    void push_back(uint64_t limb) {
+        reserve(size_ + 1);
+        data_[size_++] = limb;
+    }
+    void pop_back() { size_--; }
+    void clear() { size_ = 0; }
+};
+
+// r[0, na) = a[0, na) + b[0, nb) for na >= nb, returning the carry out
+inline uint64_t add_limbs_unequal(uint64_t* r, const uint64_t* a, size_t na, const uint64_t* b, size_t nb) {
+    uint64_t carry = add_limbs(r, a, b, nb);
+    for (size_t i = nb; i < na; i++) {
+        const uint64_t sum = a[i] + carry;
+        carry = sum < carry;
+        r[i] = sum;
+    }
+    return carry;
+}
+
+// r[0, na) = a[0, na) - b[0, nb) for na >= nb, returning the borrow out
+inline uint64_t sub_limbs_unequal(uint64_t* r, const uint64_t* a, size_t na, const uint64_t* b, size_t nb) {
+    uint64_t borrow = sub_limbs(r, a, b, nb);
+    for (size_t i = nb; i < na; i++) {
+        const uint64_t ai = a[i];
+        r[i] = ai - borrow;
+        borrow = ai < borrow;
+    }
+    return borrow;
+}
+
+inline size_t trimmed_size(const uint64_t* a, size_t n) {
+    while (n > 0 && a[n - 1] == 0) n--;
+    return n;
+}
+
+inline void mul_limbs(uint64_t* r, const uint64_t* a, size_t na, const uint64_t* b, size_t nb);
+
+// Karatsuba step for na >= nb > na / 2
+inline void mul_karatsuba(uint64_t* r, const uint64_t* a, size_t na, const uint64_t* b, size_t nb) {
+    const size_t h = (na + 1) / 2;
+    const size_t n = na + nb;
+    if (nb <= h) {
+        // Only a splits: r = a0 b + (a1 b) << h
+        std::vector<uint64_t> high(na - h + nb);
+        mul_limbs(r, a, h, b, nb);
+        std::fill(r + h + nb, r + n, 0);
+        mul_limbs(high.data(), a + h, na - h, b, nb);
+        add_limbs_unequal(r + h, r + h, n - h, high.data(), high.size());
+        return;
+    }
+
+    // z0 = a0 b0 and z2 = a1 b1 go straight into r
+    mul_limbs(r, a, h, b, h);
+    mul_limbs(r + 2 * h, a + h, na - h, b + h, nb - h);
+
+    // z1 = (a0 + a1)(b0 + b1) - z0 - z2
+    std::vector<uint64_t> sa(h + 1), sb(h + 1), z1(2 * h + 2);
+    sa[h] = add_limbs_unequal(sa.data(), a, h, a + h, na - h);
+    sb[h] = add_limbs_unequal(sb.data(), b, h, b + h, nb - h);
+    mul_limbs(z1.data(), sa.data(), h + 1, sb.data(), h + 1);
+    sub_limbs_unequal(z1.data(), z1.data(), z1.size(), r, 2 * h);
+    sub_limbs_unequal(z1.data(), z1.data(), z1.size(), r + 2 * h, n - 2 * h);
+
+    add_limbs_unequal(r + h, r + h, n - h, z1.data(), trimmed_size(z1.data(), std::min(z1.size(), n - h)));
+}
+
+// Sign-magnitude values for the Toom-3 interpolation
+struct signed_limbs {
+    std::vector<uint64_t> mag;  // trimmed
+    bool negative = false;
+
+    signed_limbs() = default;
+    signed_limbs(const uint64_t* a, size_t n) : mag(a, a + trimmed_size(a, n)) {}
+
+    void trim() {
+        mag.resize(trimmed_size(mag.data(), mag.size()));
+        if (mag.empty()) negative = false;
+    }
+
+    static bool less_magnitude(const signed_limbs& x, const signed_limbs& y) {
+        if (x.mag.size() != y.mag.size()) return x.mag.size() < y.mag.size();
+        return std::lexicographical_compare(x.mag.rbegin(), x.mag.rend(), y.mag.rbegin(), y.mag.rend());
+    }
+
+    friend signed_limbs operator+(const signed_limbs& x, const signed_limbs& y) {
+        if (x.mag.size() < y.mag.size()) return y + x;
+        signed_limbs r;
+        r.mag.resize(x.mag.size() + 1);
+        if (x.negative == y.negative) {
+            r.mag.back() = add_limbs_unequal(r.mag.data(), x.mag.data(), x.mag.size(), y.mag.data(), y.mag.size());
+            r.negative = x.negative;
+        } else if (less_magnitude(x, y)) {
+            sub_limbs_unequal(r.mag.data(), y.mag.data(), y.mag.size(), x.mag.data(), x.mag.size());
+            r.negative = y.negative;
+        } else {
+            sub_limbs_unequal(r.mag.data(), x.mag.data(), x.mag.size(), y.mag.data(), y.mag.size());
+            r.negative = x.negative;
+        }
+        r.trim();
+        return r;
+    }
+
+    friend signed_limbs operator-(const signed_limbs& x, signed_limbs y) {
+        y.negative = !y.negative;
+        return x + y;
+    }
+
+    friend signed_limbs operator*(const signed_limbs& x, const signed_limbs& y) {
+        signed_limbs r;
+        if (x.mag.empty() || y.mag.empty()) return r;
+        r.mag.resize(x.mag.size() + y.mag.size());
+        if (x.mag.size() >= y.mag.size()) {
+            mul_limbs(r.mag.data(), x.mag.data(), x.mag.size(), y.mag.data(), y.mag.size());
+        } else {
+            mul_limbs(r.mag.data(), y.mag.data(), y.mag.size(), x.mag.data(), x.mag.size());
+        }
+        r.negative = x.negative != y.negative;
+        r.trim();
+        return r;
+    }
+
+    signed_limbs& shift_left_1() {
+        mag.push_back(0);
+        for (size_t i = mag.size() - 1; i > 0; i--) mag[i] = (mag[i] << 1) | (mag[i - 1] >> 63);
+        mag[0] <<= 1;
+        trim();
+        return *this;
+    }
+
+    // Exact division by a small word
+    signed_limbs& divide_exact(uint64_t d) {
+        uint64_t rem = 0;
+        for (size_t i = mag.size(); i-- > 0;) mag[i] = div_2by1(rem, mag[i], d, rem);
+        trim();
+        return *this;
+    }
+};
+
+// Toom-3 step (Bodrato's sequence, points 0, 1, -1, -2, inf) for na >= nb > na / 3
+inline void mul_toom3(uint64_t* r, const uint64_t* a, size_t na, const uint64_t* b, size_t nb) {
+    const size_t k = (na + 2) / 3;
+    auto piece = [k](const uint64_t* x, size_t n, size_t i) {
+        const size_t lo = std::min(n, i * k);
+        return signed_limbs(x + lo, std::min(n, lo + k) - lo);
+    };
+    const signed_limbs a0 = piece(a, na, 0), a1 = piece(a, na, 1), a2 = piece(a, na, 2);
+    const signed_limbs b0 = piece(b, nb, 0), b1 = piece(b, nb, 1), b2 = piece(b, nb, 2);
+
+    // Evaluate
+    signed_limbs pa = a0 + a2, pb = b0 + b2;
+    const signed_limbs a_1 = pa + a1, b_1 = pb + b1;
+    const signed_limbs a_m1 = pa - a1, b_m1 = pb - b1;
+    signed_limbs a_m2 = a_m1 + a2, b_m2 = b_m1 + b2;
+    a_m2 = a_m2.shift_left_1() - a0;
+    b_m2 = b_m2.shift_left_1() - b0;
+
+    // Pointwise products
+    const signed_limbs r0 = a0 * b0, rinf = a2 * b2;
+    signed_limbs r1 = a_1 * b_1;
+    signed_limbs r2 = a_m1 * b_m1;
+    signed_limbs r3 = a_m2 * b_m2;
+
+    // Interpolate
+    r3 = (r3 - r1).divide_exact(3);
+    r1 = (r1 - r2).divide_exact(2);
+    r2 = r2 - r0;
+    signed_limbs twice_inf = rinf;
+    r3 = (r2 - r3).divide_exact(2) + twice_inf.shift_left_1();
+    r2 = r2 + r1 - rinf;
+    r1 = r1 - r3;
+
+    // Recompose; every coefficient is non-negative now
+    const size_t n = na + nb;
+    std::fill(r, r + n, 0);
+    const signed_limbs* coefficients[] = {&r0, &r1, &r2, &r3, &rinf};
+    for (size_t i = 0; i < 5; i++) {
+        const auto& c = coefficients[i]->mag;
+        if (c.empty() || i * k >= n) continue;
+        add_limbs_unequal(r + i * k, r + i * k, n - i * k, c.data(), std::min(c.size(), n - i * k));
+    }
+}
+
+// Product through the three-prime convolution on 32-bit digits. Returns false
+// if the operands exceed convolve_exact's size limits.
+inline bool mul_ntt(uint64_t* r, const uint64_t* a, size_t na, const uint64_t* b, size_t nb) {
+    if (2 * (na + nb) > (size_t(1) << ntt_prime<998244353>::max_log)) return false;
+
+    auto split = [](const uint64_t* x, size_t len) {
+        std::vector<uint32_t> out(2 * len);
+        for (size_t i = 0; i < len; i++) {
+            out[2 * i] = static_cast<uint32_t>(x[i]);
+            out[2 * i + 1] = static_cast<uint32_t>(x[i] >> 32);
+        }
+        return out;
+    };
+    const auto c = convolve_exact(split(a, na), split(b, nb));
+
+    unsigned __int128 carry = 0;
+    for (size_t i = 0; i < na + nb; i++) {
+        uint64_t limb = 0;
+        for (size_t j = 0; j < 2; j++) {
+            if (2 * i + j < c.size()) carry += c[2 * i + j];
+            limb |= static_cast<uint64_t>(static_cast<uint32_t>(carry)) << (32 * j);
+            carry >>= 32;
+        }
+        r[i] = limb;
+    }
+    return true;
+}
+
+// r[0, na + nb) = a * b; r must not alias a or b
+inline void mul_limbs(uint64_t* r, const uint64_t* a, size_t na, const uint64_t* b, size_t nb) {
+    if (na < nb) {
+        std::swap(a, b);
+        std::swap(na, nb);
+    }
+    if (nb < big_karatsuba_limbs) {
+        mul_limbs_schoolbook(r, a, na, b, nb);
+        return;
+    }
+
+    // Very unbalanced operands: multiply nb-limb slices of a and accumulate
+    if (na >= 2 * nb) {
+        std::fill(r, r + na + nb, 0);
+        std::vector<uint64_t> partial(2 * nb);
+        for (size_t offset = 0; offset < na; offset += nb) {
+            const size_t len = std::min(nb, na - offset);
+            mul_limbs(partial.data(), a + offset, len, b, nb);
+            add_limbs_unequal(r + offset, r + offset, na + nb - offset, partial.data(), len + nb);
+        }
+        return;
+    }
+
+    if (nb >= big_ntt_limbs && mul_ntt(r, a, na, b, nb)) return;
+    if (nb >= big_toom3_limbs) {
+        mul_toom3(r, a, na, b, nb);
+    } else {
+        mul_karatsuba(r, a, na, b, nb);
+    }
+}
+
+} // namespace detail
+
+// Arbitrary-precision unsigned integer on 64-bit limbs. Up to four limbs are
+// stored inline; larger values are allocated through Alloc.
+template <typename Alloc = std::allocator<uint64_t>>
+class big_uint {
+    detail::limb_vector<Alloc> limbs_;  // least significant first, no leading zero limbs
+
+    void trim() {
+        while (!limbs_.empty() && limbs_.back() == 0) limbs_.pop_back();
+    }
+
+public:
+    using allocator_type = Alloc;
+
+    big_uint() = default;
+    explicit big_uint(const Alloc& alloc) : limbs_(alloc) {}
+
+    // From any non-negative built-in integer
+    template <typename U, std::enable_if_t<is_builtin_integer_v<U>, int> = 0>
+    big_uint(U value, const Alloc& alloc = Alloc()) : limbs_(alloc) {
+        limbs_.push_back(static_cast<uint64_t>(value));
+        if constexpr (sizeof(U) > sizeof(uint64_t)) limbs_.push_back(static_cast<uint64_t>(value >> 64));
+        trim();
+    }
+
+    template <unsigned Bits>
+    explicit big_uint(const uint_t<Bits>& value, const Alloc& alloc = Alloc()) : limbs_(alloc) {
+        limbs_.assign(value.limbs.data(), value.used_limbs());
+    }
+
+    // From a string of decimal digits
+    explicit big_uint(std::string_view decimal, const Alloc& alloc = Alloc()) : limbs_(alloc) {
+        for (size_t i = 0; i < decimal.size(); i += 19) {
+            const size_t len = std::min<size_t>(19, decimal.size() - i);
+            uint64_t chunk = 0, scale = 1;
+            for (size_t j = 0; j < len; j++) {
+                chunk = chunk * 10 + static_cast<uint64_t>(decimal[i + j] - '0');
+                scale *= 10;
+            }
+            mul_add_word(scale, chunk);
+        }
+    }
+
+    Alloc get_allocator() const { return limbs_.get_allocator(); }
+    size_t size() const { return limbs_.size(); }
+    const uint64_t* data() const { return limbs_.data(); }
+    uint64_t limb(size_t i) const { return i < limbs_.size() ? limbs_[i] : 0; }
+
+    explicit operator bool() const { return !limbs_.empty(); }
+    explicit operator uint64_t() const { return limb(0); }
+
+    // *this = *this * m + a
+    big_uint& mul_add_word(uint64_t m, uint64_t a = 0) {
+        uint64_t carry = a;
+        for (size_t i = 0; i < limbs_.size(); i++) {
+            const unsigned __int128 t = static_cast<unsigned __int128>(limbs_[i]) * m + carry;
+            limbs_[i] = static_cast<uint64_t>(t);
+            carry = static_cast<uint64_t>(t >> 64);
+        }
+        if (carry) limbs_.push_back(carry);
+        trim();
+        return *this;
+    }
+
+    friend bool operator==(const big_uint& a, const big_uint& b) {
+        return a.size() == b.size() && std::equal(a.data(), a.data() + a.size(), b.data());
+    }
+
+    friend std::strong_ordering operator<=>(const big_uint& a, const big_uint& b) {
+        if (a.size() != b.size()) return a.size() <=> b.size();
+        for (size_t i = a.size(); i-- > 0;) {
+            if (a.limbs_[i] != b.limbs_[i]) return a.limbs_[i] <=> b.limbs_[i];
+        }
+        return std::strong_ordering::equal;
+    }
+
+    big_uint& operator+=(const big_uint& b) {
+        const size_t n = std::max(size(), b.size());
+        limbs_.resize(n + 1);
+        limbs_[n] = detail::add_limbs_unequal(limbs_.data(), limbs_.data(), n, b.data(), b.size());
+        trim();
+        return *this;
+    }
+
+    // Requires *this >= b
+    big_uint& operator-=(const big_uint& b) {
+        detail::sub_limbs_unequal(limbs_.data(), limbs_.data(), size(), b.data(), b.size());
+        trim();
+        return *this;
+    }
+
+    friend big_uint operator+(big_uint a, const big_uint& b) { return a += b; }
+    friend big_uint operator-(big_uint a, const big_uint& b) { return a -= b; }
+
+    friend big_uint operator*(const big_uint& a, const big_uint& b) {
+        big_uint r(a.get_allocator());
+        if (a.size() == 0 || b.size() == 0) return r;
+        r.limbs_.resize(a.size() + b.size());
+        detail::mul_limbs(r.limbs_.data(), a.data(), a.size(), b.data(), b.size());
+        r.trim();
+        return r;
+    }
+    big_uint& operator*=(const big_uint& b) { return *this = *this * b; }
+
+    // Quotient and remainder by a single word
+    friend std::pair<big_uint, uint64_t> divmod(const big_uint& a, uint64_t d) {
+        big_uint q(a.get_allocator());
+        q.limbs_.resize(a.size());
+        uint64_t rem = 0;
+        for (size_t i = a.size(); i-- > 0;) {
+            q.limbs_[i] = detail::div_2by1(rem, a.limbs_[i], d, rem);
+        }
+        q.trim();
+        return {std::move(q), rem};
+    }
+
+    // Quotient and remainder (Knuth's algorithm D)
+    friend std::pair<big_uint, big_uint> divmod(const big_uint& a, const big_uint& b) {
+        if (b.size() <= 1) {
+            auto [q, rem] = divmod(a, b.limb(0));
+            return {std::move(q), big_uint(rem, a.get_allocator())};
+        }
+        if (a < b) return {big_uint(a.get_allocator()), a};
+
+        big_uint q(a.get_allocator()), r(a.get_allocator());
+        q.limbs_.resize(a.size() - b.size() + 1);
+        r.limbs_.resize(b.size());
+        std::vector<uint64_t> scratch(a.size() + b.size() + 1);
+        detail::divmod_limbs(a.data(), a.size(), b.data(), b.size(), q.limbs_.data(), r.limbs_.data(), scratch.data());
+        q.trim();
+        r.trim();
+        return {std::move(q), std::move(r)};
+    }
+
+    friend big_uint operator/(const big_uint& a, const big_uint& b) { return divmod(a, b).first; }
+    friend big_uint operator%(const big_uint& a, const big_uint& b) { return divmod(a, b).second; }
+    big_uint& operator/=(const big_uint& b) { return *this = *this / b; }
+    big_uint& operator%=(const big_uint& b) { return *this = *this % b; }
+
+    friend big_uint operator<<(const big_uint& a, size_t shift) {
+        big_uint r(a.get_allocator());
+        if (a.size() == 0) return r;
+        const size_t words = shift / 64;
+        const unsigned bits = shift % 64;
+        r.limbs_.resize(a.size() + words + 1);
+        for (size_t i = 0; i < a.size(); i++) {
+            r.limbs_[i + words] |= a.limbs_[i] << bits;
+            if (bits) r.limbs_[i + words + 1] = a.limbs_[i] >> (64 - bits);
+        }
+        r.trim();
+        return r;
+    }
+
+    friend big_uint operator>>(const big_uint& a, size_t shift) {
+        big_uint r(a.get_allocator());
+        const size_t words = shift / 64;
+        const unsigned bits = shift % 64;
+        if (words >= a.size()) return r;
+        r.limbs_.resize(a.size() - words);
+        for (size_t i = 0; i < r.size(); i++) {
+            r.limbs_[i] = a.limbs_[i + words] >> bits;
+            if (bits && i + words + 1 < a.size()) r.limbs_[i] |= a.limbs_[i + words + 1] << (64 - bits);
+        }
+        r.trim();
+        return r;
+    }
+
+    big_uint& operator<<=(size_t shift) { return *this = *this << shift; }
+    big_uint& operator>>=(size_t shift) { return *this = *this >> shift; }
+
+    friend size_t bit_width(const big_uint& a) {
+        return a.size() == 0 ? 0 : 64 * (a.size() - 1) + std::bit_width(a.limbs_.back());
+    }
+
+    // Decimal representation, peeling off 19 digits per single-word division
+    friend std::string to_string(const big_uint& a) {
+        if (a.size() == 0) return "0";
+        std::vector<uint64_t> chunks;
+        big_uint value = a;
+        while (value.size() != 0) {
+            auto [q, rem] = divmod(value, 10000000000000000000ULL);
+            chunks.push_back(rem);
+            value = std::move(q);
+        }
+        std::string digits = std::to_string(chunks.back());
+        for (size_t i = chunks.size() - 1; i-- > 0;) {
+            const std::string chunk = std::to_string(chunks[i]);
+            digits.append(19 - chunk.size(), '0').append(chunk);
+        }
+        return digits;
+    }
+};
+
+// Arena-friendly spellings: every container-returning API takes a trailing
+// allocator, so passing std::pmr::polymorphic_allocator over a per-request
+// monotonic_buffer_resource puts its results in that arena
+namespace pmr {
+template <typename T>
+using vector = std::vector<T, std::pmr::polymorphic_allocator<T>>;
+using big_uint = CNTCL::big_uint<std::pmr::polymorphic_allocator<uint64_t>>;
+} // namespace pmr
+
+// ===== Hugepage arena =====
+
+// Memory resource for large sieve and table buffers. Requests of at least
+// min_bytes are rounded up to whole 2 MiB pages and mapped with MAP_HUGETLB,
+// falling back to an ordinary 2 MiB-aligned mapping advised MADV_HUGEPAGE
+// (transparent huge pages), or to the upstream resource without mmap.
+// Freed mappings are kept and handed out again best-fit, so a repeated job
+// skips the page faults; release() returns them. Smaller requests go to the
+// upstream resource. Thread-safe.
+class hugepage_arena : public std::pmr::memory_resource {
+public:
+    static constexpr size_t huge_page = size_t(1) << 21;
+
+    explicit hugepage_arena(size_t min_bytes = huge_page,
+                            std::pmr::memory_resource* upstream = std::pmr::get_default_resource())
+        : min_bytes_(min_bytes), upstream_(upstream) {}
+    hugepage_arena(const hugepage_arena&) = delete;
+    hugepage_arena& operator=(const hugepage_arena&) = delete;
+    ~hugepage_arena() override {
+        release();
+        for (const auto& [p, b] : live_) unmap(p, b);
+    }
+
+    // Unmaps the cached free blocks
+    void release() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& [size, b] : free_) {
+            unmap(b.p, {size, b.mapped});
+            if (b.mapped != kind::upstream) mapped_bytes_ -= size;
+            if (b.mapped == kind::hugetlb) hugetlb_bytes_ -= size;
+        }
+        free_.clear();
+        cached_bytes_ = 0;
+    }
+
+    size_t cached_bytes() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return cached_bytes_;
+    }
+    // Bytes mapped by the arena, live or cached, and the MAP_HUGETLB part
+    size_t mapped_bytes() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return mapped_bytes_;
+    }
+    size_t hugetlb_bytes() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return hugetlb_bytes_;
+    }
+
+private:
+    enum class kind : uint8_t { upstream, hugetlb, transparent };
+    struct block { size_t size; kind mapped; };
+    struct free_block { void* p; kind mapped; };
+
+    size_t min_bytes_;
+    std::pmr::memory_resource* upstream_;
+    mutable std::mutex mutex_;
+    std::map<void*, block> live_;
+    std::multimap<size_t, free_block> free_;
+    size_t cached_bytes_ = 0, mapped_bytes_ = 0, hugetlb_bytes_ = 0;
+
+    void* do_allocate(size_t bytes, size_t alignment) override {
+        if (bytes < min_bytes_ || alignment > huge_page) return upstream_->allocate(bytes, alignment);
+        const size_t size = (bytes + huge_page - 1) / huge_page * huge_page;
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (auto it = free_.lower_bound(size); it != free_.end() && it->first <= 2 * size) {
+            void* p = it->second.p;
+            live_.emplace(p, block{it->first, it->second.mapped});
+            cached_bytes_ -= it->first;
+            free_.erase(it);
+            return p;
+        }
+        block b{size, kind::upstream};
+        void* p = map(b);
+        if (b.mapped != kind::upstream) {
+            mapped_bytes_ += size;
+            if (b.mapped == kind::hugetlb) hugetlb_bytes_ += size;
+        }
+        live_.emplace(p, b);
+        return p;
+    }
+
+    // Looks p up rather than trusting bytes, so a size on the other side of
+    // min_bytes from the allocation still finds its block; pointers the
+    // arena does not hold go to the upstream resource
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (const auto it = live_.find(p); it != live_.end()) {
+                free_.emplace(it->second.size, free_block{p, it->second.mapped});
+                cached_bytes_ += it->second.size;
+                live_.erase(it);
+                return;
+            }
+        }
+        assert((bytes < min_bytes_ || alignment > huge_page) && "hugepage_arena: unknown block");
+        upstream_->deallocate(p, bytes, alignment);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+    // A 2 MiB-aligned mapping of b.size bytes, recording how it was made
+    void* map(block& b) {
+#if HAS_POSIX_MMAP
+#ifdef MAP_HUGETLB
+        void* p = ::mmap(nullptr, b.size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (p != MAP_FAILED) {
+            b.mapped = kind::hugetlb;
+            return p;
+        }
+#endif
+        // Over-map by a page and trim both ends to an aligned window
+        void* raw = ::mmap(nullptr, b.size + huge_page, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (raw != MAP_FAILED) {
+            const uintptr_t start = reinterpret_cast<uintptr_t>(raw);
+            const uintptr_t aligned = (start + huge_page - 1) & ~uintptr_t(huge_page - 1);
+            if (aligned > start) ::munmap(raw, aligned - start);
+            ::munmap(reinterpret_cast<void*>(aligned + b.size), start + huge_page - aligned);
+#ifdef MADV_HUGEPAGE
+            ::madvise(reinterpret_cast<void*>(aligned), b.size, MADV_HUGEPAGE);
+#endif
+            b.mapped = kind::transparent;
+            return reinterpret_cast<void*>(aligned);
+        }
+#endif
+        b.mapped = kind::upstream;
+        return upstream_->allocate(b.size, huge_page);
+    }
+
+    void unmap(void* p, const block& b) {
+#if HAS_POSIX_MMAP
+        if (b.mapped != kind::upstream) {
+            ::munmap(p, b.size);
+            return;
+        }
+#endif
+        upstream_->deallocate(p, b.size, huge_page);
+    }
+};
+
+namespace detail {
+
+// Product of factors[lo, hi) by a balanced product tree, so the large
+// multiplications happen between operands of similar size
+template <typename Alloc>
+big_uint<Alloc> product_tree(const std::vector<uint64_t>& factors, size_t lo, size_t hi, const Alloc& alloc) {
+    if (hi - lo <= 16) {
+        big_uint<Alloc> result(uint64_t(1), alloc);
+        for (size_t i = lo; i < hi; i++) result.mul_add_word(factors[i]);
+        return result;
+    }
+    const size_t mid = lo + (hi - lo) / 2;
+    return product_tree(factors, lo, mid, alloc) * product_tree(factors, mid, hi, alloc);
+}
+
+} // namespace detail
+
+// n! as an exact big integer
+template <typename Alloc = std::allocator<uint64_t>>
+big_uint<Alloc> factorial(uint64_t n, const Alloc& alloc = Alloc()) {
+    // Pack consecutive factors into words before building the tree
+    std::vector<uint64_t> words;
+    uint64_t word = 1;
+    for (uint64_t i = 2; i <= n; i++) {
+        if (word > UINT64_MAX / i) {
+            words.push_back(word);
+            word = 1;
+        }
+        word *= i;
+    }
+    words.push_back(word);
+    return detail::product_tree(words, 0, words.size(), alloc);
+}
+
+// Product of all primes p <= n as an exact big integer
+template <typename Alloc = std::allocator<uint64_t>>
+big_uint<Alloc> primorial(uint32_t n, const Alloc& alloc = Alloc()) {
+    const auto primes = simd_sieve(n);
+    std::vector<uint64_t> factors(primes.begin(), primes.end());
+    return detail::product_tree(factors, 0, factors.size(), alloc);
+}
+
+// Chinese remainder reconstruction: the unique x < prod(moduli) with
+// x = residues[i] (mod moduli[i]), for pairwise coprime moduli (Garner)
+template <typename Alloc = std::allocator<uint64_t>>
+big_uint<Alloc> crt(std::span<const uint64_t> residues, std::span<const uint64_t> moduli,
+                    const Alloc& alloc = Alloc()) {
+    big_uint<Alloc> x(uint64_t(0), alloc), product(uint64_t(1), alloc);
+    for (size_t i = 0; i < moduli.size(); i++) {
+        const uint64_t m = moduli[i];
+        if (m == 1) continue;
+
+        // t = (r_i - x) / product (mod m), then x += product * t
+        const uint64_t x_mod = divmod(x, m).second;
+        const uint64_t product_mod = divmod(product, m).second;
+        const uint64_t r = residues[i] % m;
+        const uint64_t diff = r >= x_mod ? r - x_mod : r + (m - x_mod);
+        const uint64_t inv = static_cast<uint64_t>(mod_inverse<__int128>(product_mod, m));
+        const uint64_t t = mulmod(diff, inv, m);
+
+        big_uint<Alloc> step = product;
+        x += step.mul_add_word(t);
+        product.mul_add_word(m);
+    }
+    return x;
+}
+
+// ===== Integer partitions =====
+
+namespace detail {
+
+// Euler's pentagonal recurrence over any random-access container of
+// unsigned values; positive and negative terms are summed separately so
+// the subtraction never goes below zero (or wraps harmlessly mod 2^k)
+template <typename Container, typename Add, typename Sub>
+constexpr void pentagonal_fill(Container& p, size_t n, Add add, Sub sub) {
+    p[0] = 1;
+    for (size_t i = 1; i <= n; i++) {
+        std::remove_cvref_t<decltype(p[0])> positive{}, negative{};
+        for (size_t k = 1;; k++) {
+            const size_t g1 = k * (3 * k - 1) / 2;
+            if (g1 > i) break;
+            const size_t g2 = g1 + k;
+            auto& acc = (k & 1) ? positive : negative;
+            acc = add(acc, p[i - g1]);
+            if (g2 <= i) acc = add(acc, p[i - g2]);
+        }
+        p[i] = sub(positive, negative);
+    }
+}
+
+} // namespace detail
+
+// Partition numbers p(0..n), exact as long as p(n) fits in T.
+// The default unsigned __int128 holds every p(n) up to n = 1462;
+// big_uint<> has no limit.
+template <typename T = unsigned __int128, typename Alloc = std::allocator<T>>
+std::vector<T, Alloc> partition_table(size_t n, const Alloc& alloc = Alloc()) {
+    std::vector<T, Alloc> p(n + 1, alloc);
+    detail::pentagonal_fill(p, n,
+        [](const T& a, const T& b) { return a + b; },
+        [](const T& a, const T& b) { return a - b; });
+    return p;
+}
+
+// Partition numbers p(0..N) as a compile-time table
+template <size_t N, typename T = uint64_t>
+constexpr std::array<T, N + 1> partition_array() {
+    std::array<T, N + 1> p{};
+    detail::pentagonal_fill(p, N,
+        [](T a, T b) { return a + b; },
+        [](T a, T b) { return a - b; });
+    return p;
+}
+
+// Partition numbers p(0..n) mod m by the pentagonal recurrence, O(n^1.5)
+template <typename Alloc = std::allocator<uint64_t>>
+std::vector<uint64_t, Alloc> partition_table_mod(size_t n, uint64_t m, const Alloc& alloc = Alloc()) {
+    std::vector<uint64_t, Alloc> p(n + 1, alloc);
+    detail::pentagonal_fill(p, n,
+        [m](uint64_t a, uint64_t b) { return a >= m - b ? a - (m - b) : a + b; },
+        [m](uint64_t a, uint64_t b) { return a >= b ? a - b : a + (m - b); });
+    if (m == 1) std::fill(p.begin(), p.end(), 0);
+    return p;
+}
+
+// Partition numbers p(0..n) mod an NTT prime P in O(n log n), by inverting
+// Euler's function prod(1 - x^k) = sum (-1)^k x^(k(3k-1)/2)
+template <uint32_t P = 998244353>
+std::vector<uint32_t> partition_numbers_ntt(size_t n) {
+    std::vector<uint32_t> euler(n + 1, 0);
+    euler[0] = 1;
+    for (size_t k = 1;; k++) {
+        const size_t g1 = k * (3 * k - 1) / 2;
+        if (g1 > n) break;
+        const uint32_t sign = (k & 1) ? P - 1 : 1;
+        euler[g1] = sign;
+        if (g1 + k <= n) euler[g1 + k] = sign;
+    }
+    return ntt_inverse_series<P>(euler, n + 1);
+}
+
+// ===== Stirling, Bell and Catalan numbers =====
+
+// Generator for rows of a combinatorial triangle. Every row is yielded as a
+// view into a single buffer owned by the coroutine, which is updated in
+// place, so the view is only valid until the next call to next().
+template <typename T>
+struct row_generator {
+    struct promise_type {
+        std::span<const T> value;
+        
+        row_generator get_return_object() {
+            return {std::coroutine_handle<promise_type>::from_promise(*this)};
+        }
+        
+        std::suspend_always initial_suspend() { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+        std::suspend_always yield_value(std::span<const T> row) {
+            value = row;
+            return {};
+        }
+        void unhandled_exception() { std::terminate(); }
+        void return_void() {}
+    };
+    
+    std::coroutine_handle<promise_type> handle;
+    
+    row_generator(std::coroutine_handle<promise_type> h) : handle(h) {}
+    row_generator(row_generator&& other) noexcept : handle(std::exchange(other.handle, {})) {}
+    ~row_generator() { if (handle) handle.destroy(); }
+    
+    std::span<const T> next() {
+        handle.resume();
+        return handle.promise().value;
+    }
+    
+    bool done() const { return handle.done(); }
+};
+
+namespace detail {
+
+// Exact arithmetic in T
+template <typename T>
+struct exact_ops {
+    T one() const { return T(1); }
+    T add(const T& a, const T& b) const { return a + b; }
+    T mul(uint64_t k, const T& a) const { return T(k) * a; }
+};
+
+// Arithmetic mod m for 64-bit residues
+struct mod_ops {
+    uint64_t m;
+    uint64_t one() const { return 1 % m; }
+    uint64_t add(uint64_t a, uint64_t b) const { return a >= m - b ? a - (m - b) : a + b; }
+    uint64_t mul(uint64_t k, uint64_t a) const { return mulmod(k % m, a, m); }
+};
+
+// Rows of c(n, k) = (n - 1) c(n - 1, k) + c(n - 1, k - 1), or of
+// S(n, k) = k S(n - 1, k) + S(n - 1, k - 1) when second_kind is set
+template <typename T, typename Ops>
+row_generator<T> stirling_rows(uint64_t max_rows, Ops ops, bool second_kind) {
+    std::vector<T> row;
+    row.reserve(max_rows);
+    for (uint64_t n = 0; n < max_rows; n++) {
+        row.push_back(n == 0 ? ops.one() : T(0));
+        for (uint64_t k = n; k >= 1; k--) {
+            row[k] = ops.add(ops.mul(second_kind ? k : n - 1, row[k]), row[k - 1]);
+        }
+        if (n > 0) row[0] = T(0);
+        co_yield std::span<const T>(row);
+    }
+}
+
+// Rows of the Bell (Aitken) triangle; row n starts with B(n) and ends with B(n + 1)
+template <typename T, typename Ops>
+row_generator<T> bell_rows(uint64_t max_rows, Ops ops) {
+    std::vector<T> row;
+    row.reserve(max_rows);
+    for (uint64_t n = 0; n < max_rows; n++) {
+        if (n == 0) {
+            row.push_back(ops.one());
+        } else {
+            // new[0] = old[n - 1], new[j] = new[j - 1] + old[j - 1]
+            T above = row[0];
+            row.push_back(row[n - 1]);
+            row[0] = row[n - 1];
+            for (uint64_t j = 1; j <= n; j++) {
+                T next_above = j < n ? row[j] : T(0);
+                row[j] = ops.add(row[j - 1], above);
+                above = next_above;
+            }
+        }
+        co_yield std::span<const T>(row);
+    }
+}
+
+} // namespace detail
+
+// Unsigned Stirling numbers of the first kind, rows n = 0..max_rows-1
+template <typename T = uint64_t>
+row_generator<T> stirling1_rows(uint64_t max_rows) {
+    return detail::stirling_rows<T>(max_rows, detail::exact_ops<T>{}, false);
+}
+
+// Stirling numbers of the second kind, rows n = 0..max_rows-1
+template <typename T = uint64_t>
+row_generator<T> stirling2_rows(uint64_t max_rows) {
+    return detail::stirling_rows<T>(max_rows, detail::exact_ops<T>{}, true);
+}
+
+// Unsigned Stirling numbers of the first kind mod m
+inline row_generator<uint64_t> stirling1_rows_mod(uint64_t max_rows, uint64_t m) {
+    return detail::stirling_rows<uint64_t>(max_rows, detail::mod_ops{m}, false);
+}
+
+// Stirling numbers of the second kind mod m
+inline row_generator<uint64_t> stirling2_rows_mod(uint64_t max_rows, uint64_t m) {
+    return detail::stirling_rows<uint64_t>(max_rows, detail::mod_ops{m}, true);
+}
+
+// Rows of the Bell triangle
+template <typename T = uint64_t>
+row_generator<T> bell_triangle_rows(uint64_t max_rows) {
+    return detail::bell_rows<T>(max_rows, detail::exact_ops<T>{});
+}
+
+// Rows of the Bell triangle mod m
+inline row_generator<uint64_t> bell_triangle_rows_mod(uint64_t max_rows, uint64_t m) {
+    return detail::bell_rows<uint64_t>(max_rows, detail::mod_ops{m});
+}
+
+// Bell numbers B(0..n) read off the Bell triangle
+template <typename T = uint64_t, typename Alloc = std::allocator<T>>
+std::vector<T, Alloc> bell_numbers(size_t n, const Alloc& alloc = Alloc()) {
+    std::vector<T, Alloc> bell(alloc);
+    bell.reserve(n + 1);
+    auto rows = bell_triangle_rows<T>(n + 1);
+    while (bell.size() <= n) bell.push_back(rows.next()[0]);
+    return bell;
+}
+
+// Bell numbers B(0..n) mod m
+template <typename Alloc = std::allocator<uint64_t>>
+std::vector<uint64_t, Alloc> bell_numbers_mod(size_t n, uint64_t m, const Alloc& alloc = Alloc()) {
+    std::vector<uint64_t, Alloc> bell(alloc);
+    bell.reserve(n + 1);
+    auto rows = bell_triangle_rows_mod(n + 1, m);
+    while (bell.size() <= n) bell.push_back(rows.next()[0]);
+    return bell;
+}
+
+// Catalan numbers C(0..n), exact as long as C(n) fits in T.
+// C(n + 1) = C(n) * (4n + 2) / (n + 2), with the division done first.
+template <typename T = uint64_t, typename Alloc = std::allocator<T>>
+std::vector<T, Alloc> catalan_numbers(size_t n, const Alloc& alloc = Alloc()) {
+    std::vector<T, Alloc> catalan({T(1)}, alloc);
+    catalan.reserve(n + 1);
+    for (uint64_t i = 0; i < n; i++) {
+        const uint64_t g = gcd<uint64_t>(4 * i + 2, i + 2);
+        catalan.push_back(catalan.back() / T((i + 2) / g) * T((4 * i + 2) / g));
+    }
+    return catalan;
+}
+
+// Catalan numbers C(0..n) mod m. Uses factorials in O(n) when m is a prime
+// above 2n, and the additive Catalan triangle in O(n^2) otherwise.
+template <typename Alloc = std::allocator<uint64_t>>
+std::vector<uint64_t, Alloc> catalan_numbers_mod(size_t n, uint64_t m, const Alloc& alloc = Alloc()) {
+    std::vector<uint64_t, Alloc> catalan(n + 1, 1 % m, alloc);
+    if (m > 2 * n && is_probable_prime(m)) {
+        // C(i) = (2i)! / (i! (i + 1)!), with factorials up to (2n)! < m
+        std::vector<uint64_t> fact(2 * n + 1, 1);
+        for (size_t i = 1; i < fact.size(); i++) fact[i] = mulmod(fact[i - 1], i, m);
+        std::vector<uint64_t> inv_fact(fact.size());
+        uint64_t inv = 1;
+        for (uint64_t base = fact.back(), e = m - 2; e > 0; e >>= 1) {
+            if (e & 1) inv = mulmod(inv, base, m);
+            base = mulmod(base, base, m);
+        }
+        inv_fact.back() = inv;
+        for (size_t i = fact.size() - 1; i > 0; i--) inv_fact[i - 1] = mulmod(inv_fact[i], i, m);
+        for (size_t i = 1; i <= n; i++) {
+            catalan[i] = mulmod(fact[2 * i], mulmod(inv_fact[i], inv_fact[i + 1], m), m);
+        }
+        return catalan;
+    }
+
+    // Catalan triangle: t(i, k) = t(i, k - 1) + t(i - 1, k), C(i) = t(i, i)
+    detail::mod_ops ops{m};
+    std::vector<uint64_t> row{1 % m};
+    row.reserve(n + 1);
+    for (size_t i = 1; i <= n; i++) {
+        row.push_back(0);
+        for (size_t k = 1; k <= i; k++) row[k] = ops.add(row[k], row[k - 1]);
+        catalan[i] = row[i];
+    }
+    return catalan;
+}
+
+// Row n of the Stirling numbers of the second kind mod an NTT prime P, from
+// S(n, k) = sum_i (-1)^i / i! * (k - i)^n / (k - i)!; requires n < P
+template <uint32_t P = 998244353>
+std::vector<uint32_t> stirling2_row_ntt(uint32_t n) {
+    std::vector<uint64_t> inv_fact(n + 1, 1);
+    uint64_t fact = 1;
+    for (uint32_t i = 1; i <= n; i++) fact = fact * i % P;
+    inv_fact[n] = modpow<uint64_t>(fact, P - 2, P);
+    for (uint32_t i = n; i > 0; i--) inv_fact[i - 1] = inv_fact[i] * i % P;
+
+    std::vector<uint32_t> alternating(n + 1), powers(n + 1);
+    for (uint32_t i = 0; i <= n; i++) {
+        alternating[i] = static_cast<uint32_t>((i & 1) && inv_fact[i] ? P - inv_fact[i] : inv_fact[i]);
+        powers[i] = static_cast<uint32_t>(modpow<uint64_t>(i, n, P) * inv_fact[i] % P);
+    }
+    auto row = ntt_multiply<P>(std::move(alternating), std::move(powers));
+    row.resize(n + 1);
+    return row;
+}
+
+// Row n of the unsigned Stirling numbers of the first kind mod an NTT prime P,
+// as the coefficients of the rising factorial x (x + 1) ... (x + n - 1)
+template <uint32_t P = 998244353>
+std::vector<uint32_t> stirling1_row_ntt(uint32_t n) {
+    if (n == 0) return {1};
+    std::vector<std::vector<uint32_t>> factors;
+    factors.reserve(n);
+    for (uint32_t i = 0; i < n; i++) factors.push_back({i % P, 1});
+
+    // Balanced product tree keeps the total cost at O(n log^2 n)
+    while (factors.size() > 1) {
+        std::vector<std::vector<uint32_t>> next;
+        next.reserve((factors.size() + 1) / 2);
+        for (size_t i = 0; i + 1 < factors.size(); i += 2) {
+            next.push_back(ntt_multiply<P>(std::move(factors[i]), std::move(factors[i + 1])));
+        }
+        if (factors.size() & 1) next.push_back(std::move(factors.back()));
+        factors = std::move(next);
+    }
+    return std::move(factors[0]);
+}
+
+// ===== Sublinear summatory functions =====
+
+namespace detail {
+
+// Run body(lo, hi) over [begin, end) split into contiguous chunks, one per thread
+template <typename F>
+void parallel_for(size_t begin, size_t end, uint32_t thread_count, F&& body) {
+    if (thread_count <= 1 || end - begin < 2 * size_t(thread_count)) {
+        body(begin, end);
+        return;
+    }
+    std::vector<std::thread> threads;
+    const size_t chunk_size = (end - begin + thread_count - 1) / thread_count;
+    for (size_t lo = begin; lo < end; lo += chunk_size) {
+        threads.emplace_back([&body, lo, hi = std::min(end, lo + chunk_size)]() { body(lo, hi); });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+}
+
+} // namespace detail
+
+// Values of a prime-summatory function G at every v = floor(x / i)
+template <typename T>
+struct prime_sum_table {
+    uint64_t x;
+    uint64_t root;
+    std::vector<T> small;  // small[v] = G(v) for v <= root
+    std::vector<T> large;  // large[i] = G(x / i) for i <= root
+    
+    explicit prime_sum_table(uint64_t x_)
+        : x(x_), root(isqrt(x_)), small(root + 1), large(root + 1) {}
+    
+    // v must be of the form floor(x / i)
+    T operator()(uint64_t v) const { return v <= root ? small[v] : large[x / v]; }
+};
+
+// Lucy_Hedgehog sieve for G(v) = sum of w(p) over primes p <= v, for a
+// completely multiplicative weight w. prefix(v) must return the sum of w(n)
+// over 2 <= n <= v. Runs in O(x^(3/4) / log x); while the per-prime update
+// loops are long enough to pay for it, they are split across one set of
+// threads that meet at a barrier between levels.
+template <typename T, typename Prefix, typename Weight>
+prime_sum_table<T> lucy_prime_sums(uint64_t x, Prefix prefix, Weight weight,
+                                   uint32_t thread_count = std::thread::hardware_concurrency()) {
+    constexpr uint64_t PARALLEL_THRESHOLD = uint64_t(1) << 15;
+    prime_sum_table<T> table(x);
+    const uint64_t r = table.root;
+    auto& small = table.small;
+    auto& large = table.large;
+    
+    for (uint64_t v = 1; v <= r; v++) small[v] = prefix(v);
+    for (uint64_t i = 1; i <= r; i++) large[i] = prefix(x / i);
+    
+    // The update for p, done in place by thread part of parts. large[i]
+    // reads large[i * p] and small[v] reads small[v / p], which must still
+    // hold their old values. A level (b / p, b] reads nothing inside itself,
+    // so it is split across the threads; the levels run in an order that
+    // reads before it writes, with sync() after each. Short stretches run
+    // on part 0 in the serial order.
+    auto sieve_prime = [&](uint64_t p, uint32_t part, uint32_t parts, auto&& sync) {
+        const T sp = small[p - 1];
+        const T wp = weight(p);
+        const uint64_t p2 = p * p;
+        auto split = [&](uint64_t lo, uint64_t hi, auto&& body) {
+            const uint64_t chunk = (hi - lo + parts - 1) / parts;
+            const uint64_t end = std::min(hi, lo + (part + 1) * chunk);
+            for (uint64_t i = lo + part * chunk; i < end; i++) body(i);
+            sync();
+        };
+        auto large_update = [&](uint64_t i) {
+            const uint64_t d = i * p;
+            large[i] = large[i] - wp * ((d <= r ? large[d] : small[x / d]) - sp);
+        };
+        auto small_update = [&](uint64_t v) {
+            small[v] = small[v] - wp * (small[v / p] - sp);
+        };
+        
+        // large: ascending over [1, b], then the levels above b outwards
+        uint64_t bounds[64];
+        int levels = 0;
+        uint64_t b = std::min(r, x / p2);
+        for (; b >= PARALLEL_THRESHOLD; b /= p) bounds[levels++] = b;
+        if (part == 0) {
+            for (uint64_t i = 1; i <= b; i++) large_update(i);
+        }
+        sync();
+        for (int k = levels - 1; k >= 0; k--) split(bounds[k] / p + 1, bounds[k] + 1, large_update);
+        
+        // small: the levels below r downwards, then descending over [p^2, b]
+        if (p2 > r) return;
+        for (b = r; b >= p2 && b - std::max(b / p, p2 - 1) >= PARALLEL_THRESHOLD; b /= p) {
+            split(std::max(b / p, p2 - 1) + 1, b + 1, small_update);
+        }
+        if (part == 0) {
+            for (uint64_t v = b; v >= p2; v--) small_update(v);
+        }
+        sync();
+    };
+    auto sieve_primes = [&](uint64_t begin, uint64_t end, uint32_t part, uint32_t parts, auto&& sync) {
+        for (uint64_t p = begin; p < end; p++) {
+            if (small[p] == small[p - 1]) continue;  // p is composite
+            sieve_prime(p, part, parts, sync);
+        }
+    };
+    
+    // The update loops only shrink as p grows; threads share the primes
+    // below split_end and the caller finishes the rest alone
+    uint64_t split_end = 2;
+    if (thread_count > 1) {
+        auto long_enough = [&](uint64_t p) {
+            return std::min(r, x / (p * p)) >= PARALLEL_THRESHOLD || (p * p <= r && r - p * p >= PARALLEL_THRESHOLD);
+        };
+        while (split_end <= r && long_enough(split_end)) split_end++;
+    }
+    if (split_end > 2) {
+        std::barrier<> sync_point(thread_count);
+        auto sync = [&sync_point]() { sync_point.arrive_and_wait(); };
+        std::vector<std::thread> workers;
+        for (uint32_t part = 1; part < thread_count; part++) {
+            workers.emplace_back([&, part]() { sieve_primes(2, split_end, part, thread_count, sync); });
+        }
+        sieve_primes(2, split_end, 0, thread_count, sync);
+        for (auto& t : workers) {
+            t.join();
+        }
+    }
+    sieve_primes(split_end, r + 1, 0, 1, []() {});
+    
+    return table;
+}
+
+namespace detail {
+
+// Second phase of min_25: S(n, j) is the sum of f(m) over 2 <= m <= n
+// whose least prime factor is at least primes[j]
+template <typename T, typename G, typename F>
+struct min25_recursion {
+    const std::vector<uint32_t>& primes;
+    const G& prime_sums;
+    const F& f;
+    
+    T operator()(uint64_t n, size_t j) const {
+        if (j > 0 && n <= primes[j - 1]) return T(0);
+        T result = prime_sums(n) - (j > 0 ? prime_sums(primes[j - 1]) : T(0));
+        for (size_t k = j; k < primes.size() && uint64_t(primes[k]) * primes[k] <= n; k++) {
+            result += term(n, k);
+        }
+        return result;
+    }
+    
+    // Contribution of m = p^e * m' with p = primes[k] and lpf(m') > p
+    T term(uint64_t n, size_t k) const {
+        const uint64_t p = primes[k];
+        T result(0);
+        uint64_t pe = p;
+        for (uint32_t e = 1; pe <= n / p; e++, pe *= p) {
+            result += f(p, e) * (*this)(n / pe, k + 1) + f(p, e + 1);
+        }
+        return result;
+    }
+};
+
+} // namespace detail
+
+// min_25 sum of a multiplicative function f(n) over 1 <= n <= x.
+// prime_sums(v) must return the sum of f(p) over primes p <= v for every
+// v = floor(x / i) (typically built from lucy_prime_sums), and f(p, e) must
+// return f(p^e). The outer loop over primes is shared between threads.
+template <typename T, typename G, typename F>
+T min25_sum(uint64_t x, const G& prime_sums, const F& f,
+            uint32_t thread_count = std::thread::hardware_concurrency()) {
+    if (x == 0) return T(0);
+    const uint64_t r = isqrt(x);
+    const std::vector<uint32_t> primes = r >= 2 ? simd_sieve(static_cast<uint32_t>(r)) : std::vector<uint32_t>{};
+    const detail::min25_recursion<T, G, F> S{primes, prime_sums, f};
+    
+    size_t outer = 0;
+    while (outer < primes.size() && uint64_t(primes[outer]) * primes[outer] <= x) outer++;
+    
+    // Small primes carry most of the work, so hand them out dynamically
+    thread_count = std::max<uint32_t>(1, std::min<uint32_t>(thread_count, static_cast<uint32_t>(outer)));
+    std::vector<T> partial(thread_count, T(0));
+    std::atomic<size_t> next{0};
+    auto worker = [&](uint32_t t) {
+        for (size_t k; (k = next.fetch_add(1, std::memory_order_relaxed)) < outer;) {
+            partial[t] += S.term(x, k);
+        }
+    };
+    if (thread_count == 1) {
+        worker(0);
+    } else {
+        std::vector<std::thread> threads;
+        for (uint32_t t = 0; t < thread_count; t++) threads.emplace_back(worker, t);
+        for (auto& t : threads) t.join();
+    }
+    
+    T result = T(1) + prime_sums(x);
+    for (const T& value : partial) result += value;
+    return result;
+}
+
+// Number of primes p <= x (Lucy_Hedgehog)
+inline uint64_t prime_count(uint64_t x, uint32_t thread_count = std::thread::hardware_concurrency()) {
+    if (x < 2) return 0;
+    auto table = lucy_prime_sums<uint64_t>(x,
+        [](uint64_t v) { return v - 1; },
+        [](uint64_t) { return uint64_t(1); }, thread_count);
+    return table(x);
+}
+
+// Sum of primes p <= x (Lucy_Hedgehog)
+inline unsigned __int128 prime_sum(uint64_t x, uint32_t thread_count = std::thread::hardware_concurrency()) {
+    using u128 = unsigned __int128;
+    if (x < 2) return 0;
+    auto table = lucy_prime_sums<u128>(x,
+        [](uint64_t v) { return u128(v) * (v + 1) / 2 - 1; },
+        [](uint64_t p) { return u128(p); }, thread_count);
+    return table(x);
+}
+
+// Sum of Euler's phi(n) over 1 <= n <= x (min_25)
+inline unsigned __int128 totient_summatory(uint64_t x, uint32_t thread_count = std::thread::hardware_concurrency()) {
+    using u128 = unsigned __int128;
+    if (x < 2) return x;
+    auto counts = lucy_prime_sums<u128>(x,
+        [](uint64_t v) { return u128(v - 1); },
+        [](uint64_t) { return u128(1); }, thread_count);
+    auto sums = lucy_prime_sums<u128>(x,
+        [](uint64_t v) { return u128(v) * (v + 1) / 2 - 1; },
+        [](uint64_t p) { return u128(p); }, thread_count);
+    auto phi_primes = [&](uint64_t v) { return sums(v) - counts(v); };
+    auto phi = [](uint64_t p, uint32_t e) {
+        u128 pe = p - 1;
+        for (uint32_t i = 1; i < e; i++) pe *= p;
+        return pe;
+    };
+    return min25_sum<u128>(x, phi_primes, phi, thread_count);
+}
+
+// Mertens function M(x), the sum of mu(n) over 1 <= n <= x (min_25)
+inline int64_t mertens(uint64_t x, uint32_t thread_count = std::thread::hardware_concurrency()) {
+    if (x < 2) return static_cast<int64_t>(x);
+    auto counts = lucy_prime_sums<uint64_t>(x,
+        [](uint64_t v) { return v - 1; },
+        [](uint64_t) { return uint64_t(1); }, thread_count);
+    auto mu_primes = [&](uint64_t v) { return -static_cast<int64_t>(counts(v)); };
+    auto mu = [](uint64_t, uint32_t e) { return e == 1 ? int64_t(-1) : int64_t(0); };
+    return min25_sum<int64_t>(x, mu_primes, mu, thread_count);
+}
+
+// ===== Polynomials over Z/pZ =====
+
+template <uint32_t P>
+class poly_mod;
+
+namespace detail {
+
+// Points per leaf of a subproduct tree; leaves are evaluated by Horner's rule
+inline constexpr size_t poly_leaf_points = 32;
+
+// Subproduct tree: level 0 holds prod (x - x_i) over each block of
+// poly_leaf_points points, and every level above multiplies adjacent pairs
+template <uint32_t P>
+std::vector<std::vector<poly_mod<P>>> subproduct_tree(std::span<const uint32_t> points, uint32_t thread_count) {
+    std::vector<std::vector<poly_mod<P>>> tree(1);
+    tree[0].resize((points.size() + poly_leaf_points - 1) / poly_leaf_points);
+    parallel_for(0, tree[0].size(), thread_count, [&](size_t lo, size_t hi) {
+        for (size_t b = lo; b < hi; b++) {
+            std::vector<uint32_t> c{1};
+            for (size_t i = b * poly_leaf_points; i < std::min(points.size(), (b + 1) * poly_leaf_points); i++) {
+                // c <- c (x - x_i)
+                const uint64_t neg = (P - points[i] % P) % P;
+                c.push_back(0);
+                for (size_t j = c.size() - 1; j > 0; j--) c[j] = static_cast<uint32_t>((c[j - 1] + c[j] * neg) % P);
+                c[0] = static_cast<uint32_t>(c[0] * neg % P);
+            }
+            tree[0][b] = poly_mod<P>(std::move(c));
+        }
+    });
+
+    while (tree.back().size() > 1) {
+        const size_t below = tree.size() - 1;
+        std::vector<poly_mod<P>> level((tree[below].size() + 1) / 2);
+        parallel_for(0, level.size(), thread_count, [&](size_t lo, size_t hi) {
+            for (size_t i = lo; i < hi; i++) {
+                level[i] = 2 * i + 1 < tree[below].size() ? tree[below][2 * i] * tree[below][2 * i + 1] : tree[below][2 * i];
+            }
+        });
+        tree.push_back(std::move(level));
+    }
+    return tree;
+}
+
+// Inverses of 1..n mod P (index 0 unused) by inv(i) = -(P / i) inv(P mod i)
+template <uint32_t P>
+std::vector<uint32_t> inverses_mod(size_t n) {
+    std::vector<uint32_t> inv(n + 1, 1);
+    for (size_t i = 2; i <= n; i++) inv[i] = static_cast<uint32_t>(uint64_t(P - P / i) * inv[P % i] % P);
+    return inv;
+}
+
+// Middle product r[k] = sum_j a[k + j] b[deg b - j] for k < count: the
+// transpose of multiplying by b. The wrapped terms of a cyclic convolution
+// of length >= a.size() all land below deg b, so no padding is needed.
+template <uint32_t P>
+std::vector<uint32_t> middle_product(const std::vector<uint32_t>& a, const std::vector<uint32_t>& b, size_t count) {
+    std::vector<uint32_t> r(count, 0);
+    if (a.empty() || b.empty()) return r;
+    const size_t deg = b.size() - 1;
+
+    if (std::min(count, b.size()) <= 32) {
+        for (size_t k = 0; k < count; k++) {
+            uint64_t sum = 0;
+            for (size_t j = 0; j <= deg && k + j < a.size(); j++) sum = (sum + uint64_t(a[k + j]) * b[deg - j]) % P;
+            r[k] = static_cast<uint32_t>(sum);
+        }
+        return r;
+    }
+
+    const size_t n = std::bit_ceil(std::max(a.size(), deg + count));
+    std::vector<uint32_t> fa(a), fb(b);
+    fa.resize(n);
+    fb.resize(n);
+    ntt<P>(fa, false);
+    ntt<P>(fb, false);
+    for (size_t i = 0; i < n; i++) fa[i] = static_cast<uint32_t>(uint64_t(fa[i]) * fb[i] % P);
+    ntt<P>(fa, true);
+    std::copy(fa.begin() + deg, fa.begin() + deg + count, r.begin());
+    return r;
+}
+
+} // namespace detail
+
+// Polynomial over Z/PZ for an NTT prime P, lowest coefficient first and with
+// no trailing zeros (the zero polynomial has no coefficients). Products go
+// through ntt_multiply; division, log and exp use Newton iteration.
+template <uint32_t P = 998244353>
+class poly_mod {
+    std::vector<uint32_t> c_;
+
+    static poly_mod from_reduced(std::vector<uint32_t> coeffs) {
+        poly_mod r;
+        r.c_ = std::move(coeffs);
+        while (!r.c_.empty() && r.c_.back() == 0) r.c_.pop_back();
+        return r;
+    }
+
+    static uint32_t inverse_of(uint32_t x) { return static_cast<uint32_t>(modpow<uint64_t>(x, P - 2, P)); }
+
+    // Values at points over a prebuilt subproduct tree of those points, by the
+    // transposed remainder tree of Bostan, Lecerf and Schost: node v carries
+    // g_v[k] = sum_j p[j + k] [x^j] 1 / Q_v with Q_v = prod (1 - x_i x), and a
+    // child's g is a middle product of its parent's with its sibling. Only
+    // the root needs a series inverse; there are no divisions per node.
+    std::vector<uint32_t> evaluate_on(const std::vector<std::vector<poly_mod>>& tree,
+                                      std::span<const uint32_t> points, uint32_t thread_count) const {
+        // Q_v is M_v = prod (x - x_i) reversed, so multiplying transposed by
+        // Q_v is a middle product with M_v itself
+        const poly_mod& root = tree.back()[0];
+        const size_t n = c_.size();
+        std::vector<uint32_t> inv_rev(n, 0);
+        const poly_mod inv = root.reversed(root.size()).inverse(n);
+        for (size_t j = 0; j < n; j++) inv_rev[n - 1 - j] = inv[j];
+        std::vector<std::vector<uint32_t>> g{detail::middle_product<P>(c_, inv_rev, points.size())};
+
+        for (size_t level = tree.size() - 1; level-- > 0;) {
+            const auto& nodes = tree[level];
+            std::vector<std::vector<uint32_t>> next(nodes.size());
+            detail::parallel_for(0, next.size(), thread_count, [&](size_t lo, size_t hi) {
+                for (size_t i = lo; i < hi; i++) {
+                    const size_t sibling = i ^ 1;
+                    next[i] = sibling < nodes.size()
+                        ? detail::middle_product<P>(g[i / 2], nodes[sibling].c_, nodes[i].size() - 1)
+                        : g[i / 2];
+                }
+            });
+            g = std::move(next);
+        }
+
+        // At a leaf, p(x_i) = sum_k g[k] [x^k] Q_leaf / (1 - x_i x)
+        std::vector<uint32_t> values(points.size());
+        detail::parallel_for(0, g.size(), thread_count, [&](size_t lo, size_t hi) {
+            for (size_t b = lo; b < hi; b++) {
+                const auto& leaf = tree[0][b].c_;
+                const size_t count = leaf.size() - 1;
+                for (size_t i = b * detail::poly_leaf_points; i < b * detail::poly_leaf_points + count; i++) {
+                    const uint64_t x = points[i] % P;
+                    uint64_t h = 1, sum = g[b][0];
+                    for (size_t k = 1; k < count; k++) {
+                        h = (leaf[count - k] + x * h) % P;
+                        sum = (sum + h * g[b][k]) % P;
+                    }
+                    values[i] = static_cast<uint32_t>(sum);
+                }
+            }
+        });
+        return values;
+    }
+
+public:
+    poly_mod() = default;
+    explicit poly_mod(std::vector<uint32_t> coeffs) : c_(std::move(coeffs)) {
+        for (auto& x : c_) x %= P;
+        while (!c_.empty() && c_.back() == 0) c_.pop_back();
+    }
+    poly_mod(std::initializer_list<uint32_t> coeffs) : poly_mod(std::vector<uint32_t>(coeffs)) {}
+
+    // Degree, or -1 for the zero polynomial
+    ptrdiff_t degree() const { return static_cast<ptrdiff_t>(c_.size()) - 1; }
+    size_t size() const { return c_.size(); }
+    bool is_zero() const { return c_.empty(); }
+    uint32_t operator[](size_t i) const { return i < c_.size() ? c_[i] : 0; }
+    const std::vector<uint32_t>& coeffs() const { return c_; }
+
+    // Value at x by Horner's rule
+    uint32_t operator()(uint32_t x) const {
+        uint64_t r = 0;
+        for (size_t i = c_.size(); i-- > 0;) r = (r * (x % P) + c_[i]) % P;
+        return static_cast<uint32_t>(r);
+    }
+
+    // p mod x^n
+    poly_mod truncated(size_t n) const {
+        return from_reduced(std::vector<uint32_t>(c_.begin(), c_.begin() + std::min(n, c_.size())));
+    }
+
+    // x^(n-1) p(1/x), for n > degree
+    poly_mod reversed(size_t n) const {
+        std::vector<uint32_t> r(n, 0);
+        for (size_t i = 0; i < std::min(n, c_.size()); i++) r[n - 1 - i] = c_[i];
+        return from_reduced(std::move(r));
+    }
+
+    poly_mod derivative() const {
+        std::vector<uint32_t> r(c_.empty() ? 0 : c_.size() - 1);
+        for (size_t i = 1; i < c_.size(); i++) r[i - 1] = static_cast<uint32_t>(uint64_t(c_[i]) * i % P);
+        return from_reduced(std::move(r));
+    }
+
+    // Antiderivative with zero constant term; needs degree + 1 < P
+    poly_mod integral() const {
+        if (c_.empty()) return {};
+        const auto inv = detail::inverses_mod<P>(c_.size());
+        std::vector<uint32_t> r(c_.size() + 1, 0);
+        for (size_t i = 0; i < c_.size(); i++) r[i + 1] = static_cast<uint32_t>(uint64_t(c_[i]) * inv[i + 1] % P);
+        return from_reduced(std::move(r));
+    }
+
+    // 1 / p mod x^n; requires p[0] != 0
+    poly_mod inverse(size_t n) const {
+        if (n == 0) return {};
+        return from_reduced(ntt_inverse_series<P>(c_, n));
+    }
+
+    // log p mod x^n as a power series; requires p[0] == 1
+    poly_mod log(size_t n) const {
+        if (n <= 1) return {};
+        return (derivative() * inverse(n - 1)).truncated(n - 1).integral();
+    }
+
+    // exp p mod x^n as a power series; requires p[0] == 0.
+    // Newton step: g <- g (1 - log g + p) mod x^(2 len)
+    poly_mod exp(size_t n) const {
+        if (n == 0) return {};
+        poly_mod g{1};
+        for (size_t len = 1; len < n; len <<= 1) {
+            poly_mod step = truncated(2 * len) - g.log(2 * len) + poly_mod{1};
+            g = (g * step).truncated(2 * len);
+        }
+        return g.truncated(n);
+    }
+
+    // Values at every point in O(n log^2 n) over a subproduct tree
+    std::vector<uint32_t> evaluate(std::span<const uint32_t> points,
+                                   uint32_t thread_count = std::thread::hardware_concurrency()) const {
+        if (c_.size() <= 2 * detail::poly_leaf_points || points.size() <= detail::poly_leaf_points) {
+            std::vector<uint32_t> values(points.size());
+            for (size_t i = 0; i < points.size(); i++) values[i] = (*this)(points[i]);
+            return values;
+        }
+        return evaluate_on(detail::subproduct_tree<P>(points, thread_count), points, thread_count);
+    }
+
+    // The polynomial of degree < n through (xs[i], ys[i]); xs must be distinct mod P
+    static poly_mod interpolate(std::span<const uint32_t> xs, std::span<const uint32_t> ys,
+                                uint32_t thread_count = std::thread::hardware_concurrency()) {
+        if (xs.empty()) return {};
+        const auto tree = detail::subproduct_tree<P>(xs, thread_count);
+
+        // Lagrange weights y_i / M'(x_i) with M = prod (x - x_i)
+        const auto derivative_values = tree.back()[0].derivative().evaluate_on(tree, xs, thread_count);
+
+        // Leaves: sum of w_i M_leaf / (x - x_i), dividing synthetically
+        std::vector<poly_mod> sums(tree[0].size());
+        detail::parallel_for(0, sums.size(), thread_count, [&](size_t lo, size_t hi) {
+            for (size_t b = lo; b < hi; b++) {
+                const auto& leaf = tree[0][b].c_;
+                const size_t count = leaf.size() - 1;
+                std::vector<uint32_t> acc(count, 0), quotient(count);
+                for (size_t i = b * detail::poly_leaf_points; i < b * detail::poly_leaf_points + count; i++) {
+                    const uint64_t x = xs[i] % P;
+                    const uint64_t w = ys[i] % P * uint64_t(inverse_of(derivative_values[i])) % P;
+                    quotient[count - 1] = leaf[count];
+                    for (size_t k = count - 1; k > 0; k--) quotient[k - 1] = static_cast<uint32_t>((leaf[k] + x * quotient[k]) % P);
+                    for (size_t k = 0; k < count; k++) acc[k] = static_cast<uint32_t>((acc[k] + w * quotient[k]) % P);
+                }
+                sums[b] = from_reduced(std::move(acc));
+            }
+        });
+
+        // Combine up the tree: s = s_left M_right + s_right M_left
+        for (size_t level = 1; level < tree.size(); level++) {
+            std::vector<poly_mod> next(tree[level].size());
+            detail::parallel_for(0, next.size(), thread_count, [&](size_t lo, size_t hi) {
+                for (size_t i = lo; i < hi; i++) {
+                    if (2 * i + 1 < sums.size()) {
+                        next[i] = sums[2 * i] * tree[level - 1][2 * i + 1] + sums[2 * i + 1] * tree[level - 1][2 * i];
+                    } else {
+                        next[i] = std::move(sums[2 * i]);
+                    }
+                }
+            });
+            sums = std::move(next);
+        }
+        return std::move(sums[0]);
+    }
+
+    friend bool operator==(const poly_mod&, const poly_mod&) = default;
+
+    friend poly_mod operator+(const poly_mod& a, const poly_mod& b) {
+        std::vector<uint32_t> r(std::max(a.size(), b.size()));
+        for (size_t i = 0; i < r.size(); i++) {
+            const uint32_t s = a[i] + b[i];
+            r[i] = s >= P ? s - P : s;
+        }
+        return from_reduced(std::move(r));
+    }
+
+    friend poly_mod operator-(const poly_mod& a, const poly_mod& b) {
+        std::vector<uint32_t> r(std::max(a.size(), b.size()));
+        for (size_t i = 0; i < r.size(); i++) r[i] = a[i] >= b[i] ? a[i] - b[i] : a[i] + (P - b[i]);
+        return from_reduced(std::move(r));
+    }
+
+    friend poly_mod operator*(const poly_mod& a, const poly_mod& b) {
+        return from_reduced(ntt_multiply<P>(a.c_, b.c_));
+    }
+
+    // Quotient and remainder; b must be nonzero. Newton's inverse of the
+    // reversed divisor gives the quotient in O(M(n)) for large operands.
+    friend std::pair<poly_mod, poly_mod> divmod(const poly_mod& a, const poly_mod& b) {
+        if (a.size() < b.size()) return {poly_mod(), a};
+        const size_t k = a.size() - b.size() + 1;
+
+        if (std::min(k, b.size()) <= 64) {
+            std::vector<uint32_t> r = a.c_, q(k);
+            const uint64_t lead_inv = inverse_of(b.c_.back());
+            for (size_t i = k; i-- > 0;) {
+                const uint64_t t = r[i + b.size() - 1] * lead_inv % P;
+                q[i] = static_cast<uint32_t>(t);
+                if (t == 0) continue;
+                const uint64_t neg = P - t;
+                for (size_t j = 0; j < b.size(); j++) r[i + j] = static_cast<uint32_t>((r[i + j] + neg * b.c_[j]) % P);
+            }
+            r.resize(b.size() - 1);
+            return {from_reduced(std::move(q)), from_reduced(std::move(r))};
+        }
+
+        const poly_mod q = (a.reversed(a.size()).truncated(k) * b.reversed(b.size()).inverse(k)).truncated(k).reversed(k);
+        return {q, (a - b * q).truncated(b.size() - 1)};
+    }
+
+    friend poly_mod operator/(const poly_mod& a, const poly_mod& b) { return divmod(a, b).first; }
+    friend poly_mod operator%(const poly_mod& a, const poly_mod& b) { return divmod(a, b).second; }
+};
+
+// a(b(x)) mod x^n by Brent-Kung baby steps b^0..b^(k-1) and giant step b^k,
+// k ~ sqrt(deg a): O(n^2) scalar work plus O(sqrt(n)) NTT products
+template <uint32_t P>
+poly_mod<P> compose(const poly_mod<P>& a, const poly_mod<P>& b, size_t n) {
+    if (n == 0 || a.is_zero()) return {};
+    size_t k = 1;
+    while (k * k < a.size()) k++;
+
+    std::vector<poly_mod<P>> powers{poly_mod<P>{1}};
+    for (size_t i = 1; i <= k; i++) powers.push_back((powers.back() * b.truncated(n)).truncated(n));
+
+    // Horner over the giant steps: a(b) = sum_j A_j(b) (b^k)^j, deg A_j < k
+    poly_mod<P> result;
+    for (size_t j = (a.size() + k - 1) / k; j-- > 0;) {
+        std::vector<uint32_t> block(n, 0);
+        for (size_t i = 0; i < k && j * k + i < a.size(); i++) {
+            const uint64_t coeff = a[j * k + i];
+            if (coeff == 0) continue;
+            const auto& power = powers[i].coeffs();
+            for (size_t t = 0; t < power.size(); t++) block[t] = static_cast<uint32_t>((block[t] + coeff * power[t]) % P);
+        }
+        result = (result * powers[k]).truncated(n) + poly_mod<P>(std::move(block));
+    }
+    return result;
+}
+
+// ===== Polynomial factorization and roots mod p =====
+
+namespace detail {
+
+// Product of polynomials with coefficients mod m (lowest degree first).
+// Coefficients are split into 32-bit halves for convolve_exact when m >= 2^32,
+// and operands longer than its limit into blocks of products.
+inline std::vector<uint64_t> poly_multiply_mod(const std::vector<uint64_t>& a, const std::vector<uint64_t>& b, uint64_t m) {
+    if (a.empty() || b.empty()) return {};
+    auto add = [m](uint64_t x, uint64_t y) { return x >= m - y ? x - (m - y) : x + y; };
+    std::vector<uint64_t> r(a.size() + b.size() - 1, 0);
+
+    constexpr size_t block = convolve_exact_max_terms;
+    if (a.size() > block || b.size() > block) {
+        for (size_t i = 0; i < a.size(); i += block) {
+            for (size_t j = 0; j < b.size(); j += block) {
+                const auto part = poly_multiply_mod(std::vector<uint64_t>(a.begin() + i, a.begin() + std::min(a.size(), i + block)),
+                                                    std::vector<uint64_t>(b.begin() + j, b.begin() + std::min(b.size(), j + block)), m);
+                for (size_t k = 0; k < part.size(); k++) r[i + j + k] = add(r[i + j + k], part[k]);
+            }
+        }
+        return r;
+    }
+
+    if (std::min(a.size(), b.size()) <= 32) {
+        for (size_t i = 0; i < a.size(); i++) {
+            for (size_t j = 0; j < b.size(); j++) r[i + j] = add(r[i + j], mulmod(a[i], b[j], m));
+        }
+        return r;
+    }
+
+    auto half = [](const std::vector<uint64_t>& x, unsigned shift) {
+        std::vector<uint32_t> out(x.size());
+        for (size_t i = 0; i < x.size(); i++) out[i] = static_cast<uint32_t>(x[i] >> shift);
+        return out;
+    };
+    if (m <= UINT32_MAX) {
+        const auto c = convolve_exact(half(a, 0), half(b, 0));
+        for (size_t i = 0; i < r.size(); i++) r[i] = static_cast<uint64_t>(c[i] % m);
+        return r;
+    }
+
+    const auto a0 = half(a, 0), a1 = half(a, 32), b0 = half(b, 0), b1 = half(b, 32);
+    const auto c00 = convolve_exact(a0, b0), c01 = convolve_exact(a0, b1);
+    const auto c10 = convolve_exact(a1, b0), c11 = convolve_exact(a1, b1);
+    const uint64_t shift32 = (uint64_t(1) << 32) % m, shift64 = mulmod(shift32, shift32, m);
+    for (size_t i = 0; i < r.size(); i++) {
+        const uint64_t middle = add(static_cast<uint64_t>(c01[i] % m), static_cast<uint64_t>(c10[i] % m));
+        r[i] = add(add(static_cast<uint64_t>(c00[i] % m), mulmod(middle, shift32, m)),
+                   mulmod(static_cast<uint64_t>(c11[i] % m), shift64, m));
+    }
+    return r;
+}
+
+// Polynomial arithmetic over F_p for a runtime prime p. Polynomials are
+// coefficient vectors, lowest degree first, with no trailing zeros.
+class poly_fp {
+public:
+    using poly = std::vector<uint64_t>;
+
+    explicit poly_fp(uint64_t p) : p_(p) {}
+
+    uint64_t modulus() const { return p_; }
+
+    static void trim(poly& a) {
+        while (!a.empty() && a.back() == 0) a.pop_back();
+    }
+
+    poly reduce(std::span<const uint64_t> coeffs) const {
+        poly a(coeffs.size());
+        for (size_t i = 0; i < a.size(); i++) a[i] = coeffs[i] % p_;
+        trim(a);
+        return a;
+    }
+
+    uint64_t inverse(uint64_t a) const { return modpow<uint64_t>(a, p_ - 2, p_); }
+
+    uint64_t evaluate(const poly& a, uint64_t x) const {
+        uint64_t r = 0;
+        for (size_t i = a.size(); i-- > 0;) r = add(mulmod(r, x, p_), a[i]);
+        return r;
+    }
+
+    poly add(const poly& a, const poly& b) const {
+        poly r(std::max(a.size(), b.size()), 0);
+        for (size_t i = 0; i < r.size(); i++) r[i] = add(i < a.size() ? a[i] : 0, i < b.size() ? b[i] : 0);
+        trim(r);
+        return r;
+    }
+
+    poly sub(const poly& a, const poly& b) const {
+        poly r(std::max(a.size(), b.size()), 0);
+        for (size_t i = 0; i < r.size(); i++) r[i] = sub(i < a.size() ? a[i] : 0, i < b.size() ? b[i] : 0);
+        trim(r);
+        return r;
+    }
+
+    poly mul(const poly& a, const poly& b) const {
+        poly r = poly_multiply_mod(a, b, p_);
+        trim(r);
+        return r;
+    }
+
+    poly monic(poly a) const {
+        if (a.empty() || a.back() == 1) return a;
+        const uint64_t inv = inverse(a.back());
+        for (auto& c : a) c = mulmod(c, inv, p_);
+        return a;
+    }
+
+    poly derivative(const poly& a) const {
+        poly r(a.empty() ? 0 : a.size() - 1);
+        for (size_t i = 1; i < a.size(); i++) r[i - 1] = mulmod(a[i], i % p_, p_);
+        trim(r);
+        return r;
+    }
+
+    // 1 / a mod x^n by Newton iteration; requires a[0] != 0
+    poly inverse_series(const poly& a, size_t n) const {
+        poly b{inverse(a[0])};
+        for (size_t len = 1; len < n; len <<= 1) {
+            // b <- b (2 - a b) mod x^(2 len)
+            poly ab = mul(poly(a.begin(), a.begin() + std::min(a.size(), 2 * len)), b);
+            ab.resize(2 * len, 0);
+            for (auto& c : ab) c = c == 0 ? 0 : p_ - c;
+            ab[0] = add(ab[0], 2 % p_);
+            b = mul(ab, b);
+            b.resize(2 * len, 0);
+        }
+        b.resize(n, 0);
+        trim(b);
+        return b;
+    }
+
+    // Quotient and remainder; b must be nonzero
+    std::pair<poly, poly> divmod(const poly& a, const poly& b) const {
+        if (a.size() < b.size()) return {poly(), a};
+        const size_t k = a.size() - b.size() + 1;
+        if (std::min(k, b.size()) <= 32) {
+            poly r = a, q(k, 0);
+            const uint64_t lead_inv = inverse(b.back());
+            for (size_t i = k; i-- > 0;) {
+                const uint64_t t = mulmod(r[i + b.size() - 1], lead_inv, p_);
+                q[i] = t;
+                if (t == 0) continue;
+                for (size_t j = 0; j < b.size(); j++) r[i + j] = sub(r[i + j], mulmod(t, b[j], p_));
+            }
+            r.resize(b.size() - 1);
+            trim(r);
+            trim(q);
+            return {q, r};
+        }
+        return divmod_with(a, b, inverse_series(poly(b.rbegin(), b.rend()), k));
+    }
+
+    poly mod(const poly& a, const poly& b) const { return divmod(a, b).second; }
+
+    // a^e mod f, with f's reversed inverse computed once for all reductions
+    poly powmod(poly base, uint64_t e, const poly& f) const {
+        const size_t n = f.size() - 1;
+        const poly rev_inv = n > 32 ? inverse_series(poly(f.rbegin(), f.rend()), n) : poly();
+        auto reduce_mod_f = [&](const poly& a) {
+            if (a.size() <= n) return a;
+            return n > 32 ? divmod_with(a, f, rev_inv).second : divmod(a, f).second;
+        };
+        base = reduce_mod_f(base);
+        poly result{1};
+        for (; e > 0; e >>= 1) {
+            if (e & 1) result = reduce_mod_f(mul(result, base));
+            if (e > 1) base = reduce_mod_f(mul(base, base));
+        }
+        return reduce_mod_f(result);
+    }
+
+    // Monic gcd by Euclid's algorithm
+    poly gcd(poly a, poly b) const {
+        while (!b.empty()) {
+            a = mod(a, b);
+            std::swap(a, b);
+        }
+        return monic(std::move(a));
+    }
+
+    // Square-free factorization of monic f: (g, m) with f = prod g^m,
+    // each g square-free and the g pairwise coprime (Yun, with p-th roots)
+    std::vector<std::pair<poly, unsigned>> square_free(const poly& f) const {
+        std::vector<std::pair<poly, unsigned>> result;
+        poly c = gcd(f, derivative(f));
+        poly w = divmod(f, c).first;
+        for (unsigned i = 1; w.size() > 1; i++) {
+            poly y = gcd(w, c);
+            poly factor = divmod(w, y).first;
+            if (factor.size() > 1) result.push_back({std::move(factor), i});
+            c = divmod(c, y).first;
+            w = std::move(y);
+        }
+        if (c.size() > 1) {
+            // c' = 0, so c is a p-th power: c = d(x^p) with d^p = d over F_p
+            poly root((c.size() - 1) / p_ + 1);
+            for (size_t i = 0; i < root.size(); i++) root[i] = c[i * p_];
+            for (auto& [g, m] : square_free(root)) result.push_back({std::move(g), m * static_cast<unsigned>(p_)});
+        }
+        return result;
+    }
+
+    // Distinct-degree factorization of monic square-free f: (g, d) with g
+    // the product of f's irreducible factors of degree d
+    std::vector<std::pair<poly, unsigned>> distinct_degree(poly f) const {
+        std::vector<std::pair<poly, unsigned>> result;
+        const poly x{0, 1};
+        poly h = x;
+        for (unsigned d = 1; f.size() > 2 * d; d++) {
+            h = powmod(h, p_, f);  // x^(p^d) mod f
+            poly g = gcd(f, sub(h, x));
+            if (g.size() > 1) {
+                f = divmod(f, g).first;
+                h = mod(h, f);
+                result.push_back({std::move(g), d});
+            }
+        }
+        if (f.size() > 1) result.push_back({f, static_cast<unsigned>(f.size() - 1)});
+        return result;
+    }
+
+    // Cantor-Zassenhaus equal-degree splitting of monic square-free f whose
+    // irreducible factors all have degree d; appends those factors to out
+    void equal_degree(const poly& f, unsigned d, std::vector<poly>& out) {
+        if (f.size() - 1 <= d) {
+            out.push_back(f);
+            return;
+        }
+        for (;;) {
+            poly a(f.size() - 1);
+            for (auto& c : a) c = next_random() % p_;
+            trim(a);
+            if (a.empty()) continue;
+
+            poly t;
+            if (p_ == 2) {
+                // Trace a + a^2 + ... + a^(2^(d-1)) lies in F_2 at every root
+                poly s = a;
+                t = a;
+                for (unsigned i = 1; i < d; i++) {
+                    s = powmod(s, 2, f);
+                    t = add(t, s);
+                }
+            } else {
+                // a^((p^d - 1) / 2) = (a^(1 + p + ... + p^(d-1)))^((p - 1) / 2)
+                poly s = a;
+                t = a;
+                for (unsigned i = 1; i < d; i++) {
+                    s = powmod(s, p_, f);
+                    t = mod(mul(t, s), f);
+                }
+                t = sub(powmod(t, (p_ - 1) / 2, f), poly{1});
+            }
+
+            poly g = gcd(f, t);
+            if (g.size() > 1 && g.size() < f.size()) {
+                equal_degree(g, d, out);
+                equal_degree(divmod(f, g).first, d, out);
+                return;
+            }
+        }
+    }
+
+private:
+    uint64_t p_;
+    uint64_t state_ = 0x9E3779B97F4A7C15ULL;
+
+    uint64_t add(uint64_t a, uint64_t b) const { return a >= p_ - b ? a - (p_ - b) : a + b; }
+    uint64_t sub(uint64_t a, uint64_t b) const { return a >= b ? a - b : a + (p_ - b); }
+
+    uint64_t next_random() {
+        state_ ^= state_ << 13;
+        state_ ^= state_ >> 7;
+        state_ ^= state_ << 17;
+        return state_;
+    }
+
+    // Division by b given inv = 1 / rev(b) mod x^k for k >= deg a - deg b + 1
+    std::pair<poly, poly> divmod_with(const poly& a, const poly& b, const poly& inv) const {
+        if (a.size() < b.size()) return {poly(), a};
+        const size_t k = a.size() - b.size() + 1;
+        poly q = mul(poly(a.rbegin(), a.rbegin() + k), poly(inv.begin(), inv.begin() + std::min(inv.size(), k)));
+        q.resize(k, 0);
+        std::reverse(q.begin(), q.end());
+        trim(q);
+        poly r = sub(a, mul(b, q));
+        r.resize(std::min(r.size(), b.size() - 1));
+        trim(r);
+        return {q, r};
+    }
+};
+
+} // namespace detail
+
+// Irreducible factors over F_p of the polynomial with the given coefficients
+// (lowest degree first), monic and repeated by multiplicity, sorted by degree
+// then coefficients; the leading coefficient is dropped. p must be prime.
+inline std::vector<std::vector<uint64_t>> factor_mod_p(std::span<const uint64_t> coeffs, uint64_t p) {
+    detail::poly_fp field(p);
+    const auto f = field.monic(field.reduce(coeffs));
+    std::vector<std::vector<uint64_t>> factors;
+    if (f.size() <= 1) return factors;
+
+    for (const auto& [square_free, multiplicity] : field.square_free(f)) {
+        for (const auto& [product, degree] : field.distinct_degree(square_free)) {
+            std::vector<std::vector<uint64_t>> irreducible;
+            field.equal_degree(product, degree, irreducible);
+            for (auto& g : irreducible) {
+                for (unsigned i = 0; i < multiplicity; i++) factors.push_back(g);
+            }
+        }
+    }
+
+    std::sort(factors.begin(), factors.end(), [](const auto& a, const auto& b) {
+        return a.size() != b.size() ? a.size() < b.size()
+                                    : std::lexicographical_compare(a.rbegin(), a.rend(), b.rbegin(), b.rend());
+    });
+    return factors;
+}
+
+// Distinct roots in [0, p) of the polynomial mod prime p, ascending: the
+// linear factors of gcd(f, x^p - x), split by Cantor-Zassenhaus. A polynomial
+// that vanishes mod p is rejected with an empty result rather than listing
+// all p residues.
+template <typename Alloc = std::allocator<uint64_t>>
+std::vector<uint64_t, Alloc> roots_mod_p(std::span<const uint64_t> coeffs, uint64_t p, const Alloc& alloc = Alloc()) {
+    detail::poly_fp field(p);
+    const auto f = field.monic(field.reduce(coeffs));
+    std::vector<uint64_t, Alloc> roots(alloc);
+    if (f.empty()) return roots;
+    if (p <= 64) {
+        for (uint64_t x = 0; x < p; x++) {
+            if (field.evaluate(f, x) == 0) roots.push_back(x);
+        }
+        return roots;
+    }
+    if (f.size() == 1) return roots;
+
+    const detail::poly_fp::poly x{0, 1};
+    const auto linear = field.gcd(f, field.sub(field.powmod(x, p, f), x));
+    if (linear.size() <= 1) return roots;
+
+    std::vector<std::vector<uint64_t>> factors;
+    field.equal_degree(linear, 1, factors);
+    for (const auto& g : factors) roots.push_back(g[0] == 0 ? 0 : p - g[0]);
+    std::sort(roots.begin(), roots.end());
+    return roots;
+}
+
+// Roots mod p^k (p prime, p^k < 2^64), ascending, by Hensel lifting the
+// roots mod p one digit at a time. A root r mod p^j with f'(r) != 0 (mod p)
+// lifts uniquely; a singular one lifts to all p residues above it or none.
+// When f vanishes mod p every residue is a singular root, so the lift
+// starts from all p of them.
+template <typename Alloc = std::allocator<uint64_t>>
+std::vector<uint64_t, Alloc> roots_mod_prime_power(std::span<const uint64_t> coeffs, uint64_t p, unsigned k,
+                                                   const Alloc& alloc = Alloc()) {
+    auto evaluate = [&](uint64_t x, uint64_t m) {
+        uint64_t r = 0;
+        for (size_t i = coeffs.size(); i-- > 0;) {
+            const uint64_t c = coeffs[i] % m;
+            r = mulmod(r, x, m);
+            r = r >= m - c ? r - (m - c) : r + c;
+        }
+        return r;
+    };
+    std::vector<uint64_t> derivative(coeffs.size() > 1 ? coeffs.size() - 1 : 0);
+    for (size_t i = 1; i < coeffs.size(); i++) derivative[i - 1] = mulmod(coeffs[i] % p, i % p, p);
+    const detail::poly_fp field(p);
+
+    std::vector<uint64_t, Alloc> roots(alloc);
+    if (field.reduce(coeffs).empty()) {
+        roots.reserve(p);
+        for (uint64_t r = 0; r < p; r++) roots.push_back(r);
+    } else {
+        roots = roots_mod_p(coeffs, p, alloc);
+    }
+    uint64_t pj = p;
+    for (unsigned j = 1; j < k && !roots.empty(); j++) {
+        const uint64_t next_modulus = pj * p;
+        std::vector<uint64_t, Alloc> lifted(alloc);
+        for (uint64_t r : roots) {
+            // f(r + t p^j) = f(r) + t p^j f'(r) (mod p^(j+1))
+            const uint64_t q = evaluate(r, next_modulus) / pj;
+            const uint64_t d = field.evaluate(derivative, r % p);
+            if (d != 0) {
+                lifted.push_back(r + mulmod((p - q) % p, field.inverse(d), p) * pj);
+            } else if (q == 0) {
+                for (uint64_t t = 0; t < p; t++) lifted.push_back(r + t * pj);
+            }
+        }
+        roots = std::move(lifted);
+        pj = next_modulus;
+    }
+    std::sort(roots.begin(), roots.end());
+    return roots;
+}
+
+// All solutions x in [0, n) of f(x) = 0 (mod n), ascending: roots modulo
+// each prime power of n from prime_factors, combined by the CRT.
+template <typename Alloc = std::allocator<uint64_t>>
+std::vector<uint64_t, Alloc> solve_poly_congruence(std::span<const uint64_t> coeffs, uint64_t n,
+                                                   const Alloc& alloc = Alloc()) {
+    std::vector<uint64_t, Alloc> solutions({0}, alloc);
+    if (n == 0) return std::vector<uint64_t, Alloc>(alloc);
+    uint64_t modulus = 1;
+
+    const auto factors = prime_factors(n, alloc);
+    for (size_t i = 0; i < factors.size();) {
+        const uint64_t p = factors[i];
+        unsigned k = 0;
+        uint64_t pk = 1;
+        for (; i < factors.size() && factors[i] == p; i++, k++) pk *= p;
+
+        const auto roots = roots_mod_prime_power(coeffs, p, k, alloc);
+        if (roots.empty()) return std::vector<uint64_t, Alloc>(alloc);
+
+        // x = a (mod modulus), x = r (mod pk)
+        const uint64_t inv = static_cast<uint64_t>(mod_inverse<__int128>(modulus % pk, pk));
+        std::vector<uint64_t, Alloc> combined(alloc);
+        combined.reserve(solutions.size() * roots.size());
+        for (uint64_t a : solutions) {
+            for (uint64_t r : roots) {
+                const uint64_t diff = r >= a % pk ? r - a % pk : r + (pk - a % pk);
+                combined.push_back(a + modulus * mulmod(diff, inv, pk));
+            }
+        }
+        solutions = std::move(combined);
+        modulus *= pk;
+    }
+    std::sort(solutions.begin(), solutions.end());
+    return solutions;
+}
+
+// ===== Smooth numbers =====
+
+namespace detail {
+
+// Extends value by primes[first..] (nondecreasing, so each smooth number
+// is reached once) while the product stays within x
+template <typename F>
+void smooth_dfs(uint64_t value, size_t first, uint64_t x, const std::vector<uint32_t>& primes, F& visit) {
+    for (size_t i = first; i < primes.size() && primes[i] <= x / value; i++) {
+        const uint64_t next = value * primes[i];
+        visit(next);
+        smooth_dfs(next, i, x, primes, visit);
+    }
+}
+
+} // namespace detail
+
+// Calls visit(n) for every n in [1, x] whose prime factors are all <= bound,
+// in depth-first order; one sieve up front and no allocation per value
+template <typename F>
+void for_each_smooth(uint64_t x, uint32_t bound, F&& visit) {
+    if (x == 0) return;
+    visit(uint64_t{1});
+    const auto primes = simd_sieve(static_cast<uint32_t>(std::min<uint64_t>(bound, x)));
+    detail::smooth_dfs(1, 0, x, primes, visit);
+}
+
+// The bound-smooth numbers in [1, x], ascending
+template <typename Alloc = std::allocator<uint64_t>>
+std::vector<uint64_t, Alloc> smooth_numbers(uint64_t x, uint32_t bound, const Alloc& alloc = Alloc()) {
+    std::vector<uint64_t, Alloc> result(alloc);
+    for_each_smooth(x, bound, [&](uint64_t n) { result.push_back(n); });
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+// The bound-smooth part of each value (its prime-power factors with primes
+// <= bound), so values[i] is smooth exactly when parts[i] == values[i];
+// 0 is not smooth and gets part 1. Primes below 67 are divided out; a cofactor that is prime is settled at
+// once, which rejects values with one large prime factor. Composite
+// cofactors m go through Bernstein's remainder tree in chunks: r =
+// primorial(bound) mod m at each leaf, and gcd(m, r^16 mod m) is m's smooth
+// part because no prime >= 67 divides m more than 16 times.
+template <typename Alloc = std::allocator<uint64_t>>
+std::vector<uint64_t, Alloc> smooth_parts(std::span<const uint64_t> values, uint32_t bound,
+                                          uint32_t thread_count = std::thread::hardware_concurrency(),
+                                          const Alloc& alloc = Alloc()) {
+    constexpr uint32_t tiny_primes[] = {2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37, 41, 43, 47, 53, 59, 61};
+    std::vector<uint64_t, Alloc> parts(values.size(), alloc);
+    std::vector<uint64_t> cofactors(values.size());
+    std::vector<size_t> pending;
+
+    for (size_t i = 0; i < values.size(); i++) {
+        uint64_t m = values[i], part = 1;
+        if (m == 0) {
+            parts[i] = 1;
+            continue;
+        }
+        for (uint32_t p : tiny_primes) {
+            if (p > bound) break;
+            while (m % p == 0) {
+                m /= p;
+                part *= p;
+            }
+        }
+        parts[i] = part;
+        if (m == 1 || bound < 67) continue;
+        if (m <= bound) {
+            parts[i] *= m;
+        } else if (m >= 67 * 67 && !is_probable_prime(m)) {
+            cofactors[i] = m;
+            pending.push_back(i);
+        }
+    }
+    if (pending.empty()) return parts;
+
+    // Chunks of about the primorial's limb count balance its reduction
+    // at the root against the divisions down the tree
+    const big_uint<> primes_product = primorial(bound);
+    const size_t chunk = std::clamp<size_t>(primes_product.size(), 16, 4096);
+    detail::parallel_for(0, (pending.size() + chunk - 1) / chunk, thread_count, [&](size_t lo, size_t hi) {
+        for (size_t c = lo; c < hi; c++) {
+            const size_t begin = c * chunk, end = std::min(pending.size(), begin + chunk);
+            std::vector<std::vector<big_uint<>>> tree(1);
+            for (size_t j = begin; j < end; j++) tree[0].emplace_back(cofactors[pending[j]]);
+            while (tree.back().size() > 1) {
+                const auto& below = tree.back();
+                std::vector<big_uint<>> level;
+                for (size_t k = 0; k < below.size(); k += 2) {
+                    level.push_back(k + 1 < below.size() ? below[k] * below[k + 1] : below[k]);
+                }
+                tree.push_back(std::move(level));
+            }
+
+            std::vector<big_uint<>> rems{primes_product % tree.back()[0]};
+            for (size_t level = tree.size() - 1; level-- > 0;) {
+                std::vector<big_uint<>> next(tree[level].size());
+                for (size_t k = 0; k < next.size(); k++) next[k] = rems[k / 2] % tree[level][k];
+                rems = std::move(next);
+            }
+
+            for (size_t j = begin; j < end; j++) {
+                const uint64_t m = cofactors[pending[j]];
+                uint64_t y = static_cast<uint64_t>(rems[j - begin]);
+                for (int s = 0; s < 4; s++) y = mulmod(y, y, m);
+                parts[pending[j]] *= gcd(y, m);
+            }
+        }
+    });
+    return parts;
+}
+
+// The values whose prime factors are all <= bound, in input order
+template <typename Alloc = std::allocator<uint64_t>>
+std::vector<uint64_t, Alloc> select_smooth(std::span<const uint64_t> values, uint32_t bound,
+                                           uint32_t thread_count = std::thread::hardware_concurrency(),
+                                           const Alloc& alloc = Alloc()) {
+    const auto parts = smooth_parts(values, bound, thread_count, alloc);
+    std::vector<uint64_t, Alloc> smooth(alloc);
+    for (size_t i = 0; i < values.size(); i++) {
+        if (parts[i] == values[i]) smooth.push_back(values[i]);
+    }
+    return smooth;
+}
+
+// ===== Segmented sieve and prime k-tuples =====
+
+namespace detail {
+
+// Odd numbers per sieve segment: 32 KiB of bits, one L1 data cache
+inline constexpr size_t sieve_segment_bits = size_t(1) << 18;
+
+} // namespace detail
+
+// One sieved segment: bit i of words marks base + 2 i + 1 as prime, for the
+// count odd numbers from base + 1. Numbers outside the sieved range are
+// cleared; 2 has no bit and is reported by the callers that include it.
+struct sieve_segment {
+    uint64_t base;  // even
+    size_t count;
+    std::span<const uint64_t> words;
+
+    bool is_prime_at(size_t i) const { return (words[i / 64] >> (i % 64)) & 1; }
+
+    size_t prime_count() const {
+        size_t total = 0;
+        for (uint64_t w : words) total += std::popcount(w);
+        return total;
+    }
+
+    template <typename F>
+    void for_each_prime(F&& visit) const {
+        for (size_t w = 0; w < words.size(); w++) {
+            for (uint64_t bits = words[w]; bits != 0; bits &= bits - 1) {
+                visit(base + 2 * (64 * w + std::countr_zero(bits)) + 1);
+            }
+        }
+    }
+};
+
+namespace detail {
+
+// Odd-only bitmap with the multiples of 3, 5, 7, 11 and 13 cleared: bit j
+// stands for 2 j + 1 and repeats with period 15015. Copying it into each
+// segment replaces the densest part of the crossing-off.
+inline constexpr uint64_t presieve_period = 3 * 5 * 7 * 11 * 13;
+
+inline const bit_array& presieve_pattern() {
+    static const bit_array pattern = [] {
+        bit_array bits(64 * ((presieve_period + 128) / 64 + 1));
+        for (uint64_t j = 0; j < bits.size(); j++) {
+            const uint64_t n = 2 * (j % presieve_period) + 1;
+            if (n % 3 && n % 5 && n % 7 && n % 11 && n % 13) bits.set(j);
+        }
+        return bits;
+    }();
+    return pattern;
+}
+
+// Buffers of sieve_segments, reusable across calls
+struct sieve_scratch {
+    std::vector<uint64_t> next;
+    bit_array bits;
+};
+
+// Sieves [lo, hi) segment by segment in ascending order, calling
+// visit(const sieve_segment&); a visitor returning bool stops the sieve by
+// returning false. Each base prime keeps its next odd multiple across
+// segments, so a segment costs no divisions.
+template <typename F>
+void sieve_segments(uint64_t lo, uint64_t hi, std::span<const uint32_t> base_primes, sieve_scratch& scratch, F&& visit) {
+    if (lo >= hi) return;
+    const uint64_t span = 2 * sieve_segment_bits;
+    uint64_t base = lo & ~uint64_t(1);
+
+    // First odd multiple of each base prime past the presieved 3..13
+    // (base_primes[1..5]) that is >= max(p^2, base); multiples past 2^64
+    // saturate to UINT64_MAX, which no segment reaches
+    constexpr size_t PRESIEVED = 6;
+    std::vector<uint64_t>& next = scratch.next;
+    next.resize(base_primes.size());
+    auto saturating_add = [](uint64_t a, uint64_t b) { return a > UINT64_MAX - b ? UINT64_MAX : a + b; };
+    for (size_t k = PRESIEVED; k < base_primes.size(); k++) {
+        const uint64_t p = base_primes[k];
+        uint64_t m = std::max(p * p, saturating_add(base / p * p, p));
+        if ((m & 1) == 0) m = saturating_add(m, p);
+        next[k] = m;
+    }
+
+    const uint64_t* pattern = presieve_pattern().words();
+    bit_array& bits = scratch.bits;
+    if (bits.size() != sieve_segment_bits) bits.assign(sieve_segment_bits, false);
+    uint64_t* words = bits.words();
+    for (;;) {
+        const uint64_t end = hi - base > span ? base + span : hi;
+        const size_t count = static_cast<size_t>((end - base) / 2);  // odd numbers base + 1 .. end - 1
+        const size_t word_count = (count + 63) / 64;
+        uint64_t offset = (base / 2) % presieve_period;
+        for (size_t w = 0; w < word_count; w++) {
+            const uint64_t* src = pattern + offset / 64;
+            words[w] = offset % 64 == 0 ? src[0] : (src[0] >> (offset % 64)) | (src[1] << (64 - offset % 64));
+            offset += 64;
+            if (offset >= presieve_period) offset -= presieve_period;
+        }
+        if (count % 64) words[word_count - 1] &= (uint64_t(1) << (count % 64)) - 1;
+        for (uint64_t q : {3, 5, 7, 11, 13}) {  // the presieved primes themselves
+            if (q > base && q < end) words[0] |= uint64_t(1) << ((q - base - 1) / 2);
+        }
+
+        for (size_t k = PRESIEVED; k < base_primes.size(); k++) {
+            const uint64_t p = base_primes[k];
+            if (next[k] >= end) {
+                if (p * p >= end) break;
+                continue;
+            }
+            size_t i = static_cast<size_t>((next[k] - base) / 2);
+            for (; i < count; i += p) bits.reset(i);
+            next[k] = saturating_add(base, 2 * uint64_t(i) + 1);
+        }
+
+        if (base == 0 && count > 0) words[0] &= ~uint64_t(1);  // 1 is not prime
+        const sieve_segment segment{base, count, std::span<const uint64_t>(words, word_count)};
+        if constexpr (std::is_same_v<std::invoke_result_t<F&, const sieve_segment&>, bool>) {
+            if (!visit(segment)) break;
+        } else {
+            visit(segment);
+        }
+        if (end == hi) break;
+        base = end;
+    }
+}
+
+template <typename F>
+void sieve_segments(uint64_t lo, uint64_t hi, std::span<const uint32_t> base_primes, F&& visit) {
+    sieve_scratch scratch;
+    sieve_segments(lo, hi, base_primes, scratch, std::forward<F>(visit));
+}
+
+// Primes up to sqrt(hi), as used by every sieve over [lo, hi): those below
+// 2^16 from simd_sieve, the rest by segments over 64-bit bounds, so hi up
+// to 2^64 - 1 needs no sieve array of 2^32 bits
+inline std::vector<uint32_t> sieve_base_primes(uint64_t hi) {
+    const uint64_t root = isqrt(hi);
+    const std::vector<uint32_t> small = simd_sieve(static_cast<uint32_t>(std::min<uint64_t>(root, 65535)));
+    if (root < 65536) return small;
+    std::vector<uint32_t> primes;
+    primes.reserve(static_cast<size_t>(1.25506 * double(root) / std::log(double(root))) + 1);
+    primes.assign(small.begin(), small.end());
+    sieve_segments(65536, root + 1, small, [&](const sieve_segment& segment) {
+        for (size_t w = 0; w < segment.words.size(); w++) {
+            for (uint64_t bits = segment.words[w]; bits != 0; bits &= bits - 1) {
+                primes.push_back(static_cast<uint32_t>(segment.base + 2 * (64 * w + std::countr_zero(bits)) + 1));
+            }
+        }
+    });
+    return primes;
+}
+
+// Runs body(sub_lo, sub_hi) over contiguous, segment-aligned pieces of
+// [lo, hi), one per thread
+template <typename F>
+void parallel_ranges(uint64_t lo, uint64_t hi, uint32_t thread_count, F&& body) {
+    if (lo >= hi) return;
+    const uint64_t span = 2 * sieve_segment_bits;
+    const uint64_t first = lo & ~uint64_t(1);
+    const size_t pieces = static_cast<size_t>((hi - first + span - 1) / span);
+    parallel_for(0, pieces, thread_count, [&](size_t a, size_t b) {
+        const uint64_t sub_lo = std::max(lo, first + a * span);
+        const uint64_t sub_hi = hi - first > b * span ? first + b * span : hi;
+        body(sub_lo, sub_hi);
+    });
+}
+
+// Bitmasks of k-tuple starts: visit(base, mask) for each 64-number word of
+// odd starts p in [lo, hi) (bit b marks p = base + 2 b + 1) where every
+// p + offsets[j] is prime. Each segment's bitmap is ANDed with itself shifted
+// by offsets[j] / 2 bits, reading into the next segment near its end.
+template <typename F>
+void tuple_masks(uint64_t lo, uint64_t hi, std::span<const uint32_t> offsets,
+                 std::span<const uint32_t> base_primes, F&& visit) {
+    const uint64_t reach = offsets.empty() ? 0 : offsets.back();
+    const uint64_t sieve_hi = hi > UINT64_MAX - reach ? UINT64_MAX : hi + reach;
+    const size_t tail_words = static_cast<size_t>(reach / 2 / 64 + 2);
+
+    bit_array window, acc;  // previous segment plus the head of the next
+    uint64_t window_base = 0;
+    size_t window_words = 0;
+    bool pending = false;
+
+    auto flush = [&](std::span<const uint64_t> head) {
+        const size_t head_words = std::min(head.size(), tail_words);
+        std::copy_n(head.begin(), head_words, window.words() + window_words);
+        std::fill(window.words() + window_words + head_words, window.words() + window.word_count(), 0);
+
+        // acc[k] &= window bits starting at 64 k + shift, for each offset;
+        // locals keep the trip count invariant so these loops vectorize
+        const size_t n = window_words;
+        uint64_t* out = acc.words();
+        std::copy_n(window.words(), n, out);
+        for (uint32_t offset : offsets) {
+            const size_t shift = offset / 2, q = shift / 64, r = shift % 64;
+            const uint64_t* src = window.words() + q;
+            if (r == 0) {
+                for (size_t k = 0; k < n; k++) out[k] &= src[k];
+            } else {
+                for (size_t k = 0; k < n; k++) out[k] &= (src[k] >> r) | (src[k + 1] << (64 - r));
+            }
+        }
+        for (size_t k = 0; k < n; k++) {
+            uint64_t mask = out[k];
+            const uint64_t word_base = window_base + 128 * k;
+            if (mask == 0 || word_base >= hi) continue;
+            if (hi - word_base < 128) mask &= (uint64_t(1) << ((hi - word_base) / 2)) - 1;
+            if (mask != 0) visit(word_base, mask);
+        }
+    };
+
+    sieve_segments(lo, sieve_hi, base_primes, [&](const sieve_segment& segment) {
+        if (pending && window_base < hi) flush(segment.words);
+        if (window.size() == 0) {
+            window.assign(64 * (sieve_segment_bits / 64 + tail_words + 1), false);
+            acc.assign(sieve_segment_bits, false);
+        }
+        std::copy(segment.words.begin(), segment.words.end(), window.words());
+        window_base = segment.base;
+        window_words = segment.words.size();
+        pending = true;
+    });
+    if (pending && window_base < hi) flush({});
+}
+
+} // namespace detail
+
+// Calls visit(segment) for ascending sieve segments covering [lo, hi)
+template <typename F>
+void segmented_sieve(uint64_t lo, uint64_t hi, F&& visit) {
+    detail::sieve_segments(lo, hi, detail::sieve_base_primes(hi), visit);
+}
+
+// Calls visit(p) for every prime p in [lo, hi), ascending
+template <typename F>
+void for_each_prime(uint64_t lo, uint64_t hi, F&& visit) {
+    if (lo <= 2 && hi > 2) visit(uint64_t{2});
+    segmented_sieve(lo, hi, [&](const sieve_segment& segment) { segment.for_each_prime(visit); });
+}
+
+// Upper bound on the number of primes <= limit, a safe buffer size for
+// simd_sieve_into (Rosser and Schoenfeld: pi(x) < 1.25506 x / ln x, x > 1)
+inline size_t simd_sieve_capacity(uint32_t limit) {
+    if (limit < 2) return 0;
+    return static_cast<size_t>(1.25506 * limit / std::log(double(limit))) + 1;
+}
+
+// Writes the primes <= limit into out, ascending, and returns how many were
+// written, stopping once out is full. The segmented sieve runs on
+// thread-local scratch, so calls after a thread's first do not allocate.
+inline size_t simd_sieve_into(uint32_t limit, std::span<uint32_t> out) {
+    if (limit < 2 || out.empty()) return 0;
+    static const std::vector<uint32_t> base_primes = simd_sieve(65535);
+    thread_local detail::sieve_scratch scratch;
+
+    const auto base_end = std::upper_bound(base_primes.begin(), base_primes.end(), isqrt(limit));
+    size_t written = 0;
+    out[written++] = 2;
+    detail::sieve_segments(3, uint64_t(limit) + 1, std::span<const uint32_t>(base_primes.begin(), base_end), scratch,
+        [&](const sieve_segment& segment) {
+            for (size_t w = 0; w < segment.words.size(); w++) {
+                for (uint64_t bits = segment.words[w]; bits != 0; bits &= bits - 1) {
+                    if (written == out.size()) return false;
+                    out[written++] = static_cast<uint32_t>(segment.base + 2 * (64 * w + std::countr_zero(bits)) + 1);
+                }
+            }
+            return true;
+        });
+    return written;
+}
+
+// Number of primes in [lo, hi), with one segmented sieve per thread
+inline uint64_t count_primes_segmented(uint64_t lo, uint64_t hi,
+                                       uint32_t thread_count = std::thread::hardware_concurrency()) {
+    const auto base_primes = detail::sieve_base_primes(hi);
+    std::atomic<uint64_t> total{lo <= 2 && hi > 2 ? 1u : 0u};
+    detail::parallel_ranges(lo, hi, thread_count, [&](uint64_t sub_lo, uint64_t sub_hi) {
+        uint64_t count = 0;
+        detail::sieve_segments(sub_lo, sub_hi, base_primes, [&](const sieve_segment& s) { count += s.prime_count(); });
+        total += count;
+    });
+    return total.load();
+}
+
+// Common prime constellations, as offsets from the first member
+inline constexpr uint32_t twin_primes[] = {0, 2};
+inline constexpr uint32_t cousin_primes[] = {0, 4};
+inline constexpr uint32_t sexy_primes[] = {0, 6};
+inline constexpr uint32_t prime_triplets[] = {0, 2, 6};
+inline constexpr uint32_t prime_quadruplets[] = {0, 2, 6, 8};
+inline constexpr uint32_t prime_sextuplets[] = {0, 4, 6, 10, 12, 16};
+
+// Calls visit(p) for each p in [lo, hi), ascending, with every p + offsets[j]
+// prime. Offsets are even and ascending from 0, so tuples start at an odd prime.
+template <typename F>
+void for_each_prime_tuple(uint64_t lo, uint64_t hi, std::span<const uint32_t> offsets, F&& visit) {
+    const uint64_t reach = offsets.empty() ? 0 : offsets.back();
+    const auto base_primes = detail::sieve_base_primes(hi > UINT64_MAX - reach ? UINT64_MAX : hi + reach);
+    detail::tuple_masks(lo, hi, offsets, base_primes, [&](uint64_t base, uint64_t mask) {
+        for (; mask != 0; mask &= mask - 1) visit(base + 2 * std::countr_zero(mask) + 1);
+    });
+}
+
+// Number of p in [lo, hi) starting a prime tuple with the given offsets,
+// counted from the AND-ed bitmaps without materializing any primes
+inline uint64_t count_prime_tuples(uint64_t lo, uint64_t hi, std::span<const uint32_t> offsets,
+                                   uint32_t thread_count = std::thread::hardware_concurrency()) {
+    const uint64_t reach = offsets.empty() ? 0 : offsets.back();
+    const auto base_primes = detail::sieve_base_primes(hi > UINT64_MAX - reach ? UINT64_MAX : hi + reach);
+    std::atomic<uint64_t> total{0};
+    detail::parallel_ranges(lo, hi, thread_count, [&](uint64_t sub_lo, uint64_t sub_hi) {
+        uint64_t count = 0;
+        detail::tuple_masks(sub_lo, sub_hi, offsets, base_primes, [&](uint64_t, uint64_t mask) { count += std::popcount(mask); });
+        total += count;
+    });
+    return total.load();
+}
+
+// ===== Prime gaps =====
+
+// The gap between consecutive primes start and start + length
+struct prime_gap {
+    uint64_t start = 0;
+    uint64_t length = 0;
+
+    // length / ln(start): the gap relative to the average gap near start
+    double merit() const { return start > 1 ? double(length) / std::log(double(start)) : 0.0; }
+};
+
+// Gap statistics over the primes of a range, built in one ascending pass
+struct prime_gap_stats {
+    uint64_t prime_count = 0;
+    uint64_t first_prime = 0;                 // 0 when there are no primes
+    uint64_t last_prime = 0;
+    std::vector<uint64_t> histogram;          // histogram[g]: gaps of length g
+    std::vector<uint64_t> first_occurrence;   // smallest p starting a gap of length g, or 0
+    std::vector<prime_gap> maximal_gaps;      // each longer than every earlier gap in the range
+    prime_gap max_merit;
+
+    // Extends the statistics by the next prime of the range
+    void add_prime(uint64_t p) {
+        if (prime_count++ == 0) {
+            first_prime = p;
+        } else {
+            add_gap(last_prime, p - last_prime);
+        }
+        last_prime = p;
+    }
+
+    // Appends the statistics of the range that immediately follows this one
+    void merge(const prime_gap_stats& next) {
+        if (next.prime_count == 0) return;
+        if (prime_count == 0) {
+            *this = next;
+            return;
+        }
+        add_gap(last_prime, next.first_prime - last_prime);
+        if (histogram.size() < next.histogram.size()) {
+            histogram.resize(next.histogram.size());
+            first_occurrence.resize(next.histogram.size());
+        }
+        for (size_t g = 0; g < next.histogram.size(); g++) {
+            histogram[g] += next.histogram[g];
+            if (first_occurrence[g] == 0) first_occurrence[g] = next.first_occurrence[g];
+        }
+        for (const prime_gap& gap : next.maximal_gaps) {
+            if (gap.length > maximal_gaps.back().length) maximal_gaps.push_back(gap);
+        }
+        if (next.best_merit_ > best_merit_) {
+            best_merit_ = next.best_merit_;
+            max_merit = next.max_merit;
+        }
+        prime_count += next.prime_count;
+        last_prime = next.last_prime;
+    }
+
+private:
+    double best_merit_ = 0.0;
+
+    void add_gap(uint64_t start, uint64_t length) {
+        if (length >= histogram.size()) {
+            histogram.resize(length + 1);
+            first_occurrence.resize(length + 1);
+        }
+        if (histogram[length]++ == 0) first_occurrence[length] = start;
+        if (maximal_gaps.empty() || length > maximal_gaps.back().length) maximal_gaps.push_back({start, length});
+
+        // ln(start) >= (bit_width - 1) ln 2 screens out nearly every log
+        if (double(length) > best_merit_ * double(std::bit_width(start) - 1) * 0.6931471805599453) {
+            const prime_gap gap{start, length};
+            if (gap.merit() > best_merit_) {
+                best_merit_ = gap.merit();
+                max_merit = gap;
+            }
+        }
+    }
+};
+
+// Gap histogram, first occurrences, maximal gaps and the largest merit over
+// the primes in [lo, hi), streamed from the segmented sieve. Each thread
+// fills its own statistics for a contiguous subrange; merging them in order
+// adds the gaps that span the subrange boundaries.
+inline prime_gap_stats prime_gap_statistics(uint64_t lo, uint64_t hi,
+                                            uint32_t thread_count = std::thread::hardware_concurrency()) {
+    const auto base_primes = detail::sieve_base_primes(hi);
+    std::vector<std::pair<uint64_t, prime_gap_stats>> pieces(std::max<uint32_t>(thread_count, 1));
+    std::atomic<size_t> used{0};
+
+    detail::parallel_ranges(lo, hi, thread_count, [&](uint64_t sub_lo, uint64_t sub_hi) {
+        prime_gap_stats stats;
+        if (sub_lo <= 2 && sub_hi > 2) stats.add_prime(2);
+        detail::sieve_segments(sub_lo, sub_hi, base_primes, [&](const sieve_segment& segment) {
+            segment.for_each_prime([&](uint64_t p) { stats.add_prime(p); });
+        });
+        pieces[used++] = {sub_lo, std::move(stats)};
+    });
+
+    std::sort(pieces.begin(), pieces.begin() + used, [](const auto& a, const auto& b) { return a.first < b.first; });
+    prime_gap_stats result;
+    for (size_t i = 0; i < used; i++) result.merge(pieces[i].second);
+    return result;
+}
+
+// ===== Prime tables on disk =====
+//
+// Little-endian layout, version 1:
+//   [0, 80)       header: magic "CNTCLPT", version, checkpoint interval,
+//                 lo, hi, prime count, flags, then offset/size of the gap
+//                 stream and offset/count of the checkpoints
+//   gap stream    one byte g / 2 per gap g between consecutive odd primes;
+//                 byte 0 escapes to a two-byte half-gap
+//   checkpoints   8-byte aligned {prime, gap stream offset} pairs for odd
+//                 prime 0, K, 2K, ...
+// 2 has no gap and is recorded by a flag, so a table costs a little over one
+// byte per prime.
+
+namespace detail {
+
+inline constexpr unsigned char prime_table_magic[8] = {'C', 'N', 'T', 'C', 'L', 'P', 'T', 0};
+inline constexpr uint32_t prime_table_version = 1;
+inline constexpr uint32_t prime_table_interval = 256;  // odd primes per checkpoint
+inline constexpr size_t prime_table_header_bytes = 80;
+inline constexpr uint64_t prime_table_has_two = 1;
+
+inline uint64_t load_le(const unsigned char* p, unsigned bytes) {
+    uint64_t v = 0;
+    for (unsigned i = bytes; i-- > 0;) v = (v << 8) | p[i];
+    return v;
+}
+
+inline void store_le(unsigned char* p, uint64_t v, unsigned bytes) {
+    for (unsigned i = 0; i < bytes; i++, v >>= 8) p[i] = static_cast<unsigned char>(v);
+}
+
+// Decodes the gap at gaps[pos], advancing pos past it; a stream cut short
+// before end (a corrupt table) reads as zero gaps
+inline uint64_t read_prime_gap(const unsigned char* gaps, size_t& pos, size_t end) {
+    if (pos >= end) return 0;
+    const uint64_t half = gaps[pos++];
+    if (half != 0) return 2 * half;
+    if (end - pos < 2) {
+        pos = end;
+        return 0;
+    }
+    pos += 2;
+    return 2 * load_le(gaps + pos - 2, 2);
+}
+
+} // namespace detail
+
+// Writes the primes in [lo, hi) to path as a prime table, streaming them from
+// the segmented sieve. Returns false if the file cannot be written.
+inline bool write_prime_table(const std::string& path, uint64_t lo, uint64_t hi) {
+    std::FILE* file = std::fopen(path.c_str(), "wb");
+    if (file == nullptr) return false;
+    constexpr size_t HEADER = detail::prime_table_header_bytes;
+    constexpr uint32_t K = detail::prime_table_interval;
+
+    unsigned char header[HEADER] = {};
+    bool ok = std::fwrite(header, 1, HEADER, file) == HEADER;
+    std::vector<unsigned char> buffer;
+    auto flush = [&] {
+        ok = ok && std::fwrite(buffer.data(), 1, buffer.size(), file) == buffer.size();
+        buffer.clear();
+    };
+
+    std::vector<uint64_t> checkpoints;  // prime, offset pairs
+    uint64_t odd_count = 0, gap_bytes = 0, last = 0;
+    buffer.reserve(1 << 16);
+    segmented_sieve(std::max<uint64_t>(lo, 3), hi, [&](const sieve_segment& segment) {
+        segment.for_each_prime([&](uint64_t p) {
+            if (odd_count > 0) {
+                const uint64_t half = (p - last) / 2;
+                if (half < 256) {
+                    buffer.push_back(static_cast<unsigned char>(half));
+                    gap_bytes++;
+                } else {
+                    buffer.insert(buffer.end(), {0, static_cast<unsigned char>(half), static_cast<unsigned char>(half >> 8)});
+                    gap_bytes += 3;
+                }
+            }
+            if (odd_count++ % K == 0) checkpoints.insert(checkpoints.end(), {p, gap_bytes});
+            last = p;
+        });
+        if (buffer.size() >= (1 << 16)) flush();
+    });
+    flush();
+
+    const uint64_t checkpoint_offset = (HEADER + gap_bytes + 7) & ~uint64_t(7);
+    buffer.assign(checkpoint_offset - HEADER - gap_bytes, 0);
+    for (uint64_t v : checkpoints) {
+        buffer.resize(buffer.size() + 8);
+        detail::store_le(buffer.data() + buffer.size() - 8, v, 8);
+    }
+    flush();
+
+    const bool has_two = lo <= 2 && hi > 2;
+    std::copy(std::begin(detail::prime_table_magic), std::end(detail::prime_table_magic), header);
+    detail::store_le(header + 8, detail::prime_table_version, 4);
+    detail::store_le(header + 12, K, 4);
+    detail::store_le(header + 16, lo, 8);
+    detail::store_le(header + 24, hi, 8);
+    detail::store_le(header + 32, odd_count + has_two, 8);
+    detail::store_le(header + 40, has_two ? detail::prime_table_has_two : 0, 8);
+    detail::store_le(header + 48, HEADER, 8);
+    detail::store_le(header + 56, gap_bytes, 8);
+    detail::store_le(header + 64, checkpoint_offset, 8);
+    detail::store_le(header + 72, checkpoints.size() / 2, 8);
+    ok = ok && std::fseek(file, 0, SEEK_SET) == 0 && std::fwrite(header, 1, HEADER, file) == HEADER;
+    return std::fclose(file) == 0 && ok;
+}
+
+// Read-only prime table. open() memory-maps the file where the platform
+// allows, so every process reading the same table shares it through the page
+// cache; view() wraps bytes the caller keeps alive. Index 0 is the smallest
+// prime in [lo, hi).
+class prime_table {
+public:
+    class iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = uint64_t;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const uint64_t*;
+        using reference = uint64_t;
+
+        iterator() = default;
+        uint64_t operator*() const { return value_; }
+        iterator& operator++() {
+            if (++index_ < table_->count_) {
+                if (table_->has_two_ && index_ == 1) {
+                    value_ = table_->checkpoint_prime(0);
+                } else {
+                    value_ += detail::read_prime_gap(table_->gaps_, pos_, table_->gap_bytes_);
+                }
+            }
+            return *this;
+        }
+        iterator operator++(int) {
+            iterator old = *this;
+            ++*this;
+            return old;
+        }
+        bool operator==(const iterator& other) const { return index_ == other.index_; }
+
+    private:
+        friend class prime_table;
+        iterator(const prime_table* table, size_t index, uint64_t value) : table_(table), index_(index), value_(value) {}
+
+        const prime_table* table_ = nullptr;
+        size_t index_ = 0;
+        uint64_t value_ = 0;
+        size_t pos_ = 0;
+    };
+
+    // Maps the table at path; nullopt if it is missing or not a valid table
+    static std::optional<prime_table> open(const std::string& path) {
+        prime_table table;
+#if HAS_POSIX_MMAP
+        const int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return std::nullopt;
+        struct stat info;
+        void* mapping = MAP_FAILED;
+        if (::fstat(fd, &info) == 0 && info.st_size > 0) {
+            mapping = ::mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_SHARED, fd, 0);
+        }
+        ::close(fd);
+        if (mapping == MAP_FAILED) return std::nullopt;
+        table.mapping_ = mapping;
+        table.bytes_ = {static_cast<const unsigned char*>(mapping), static_cast<size_t>(info.st_size)};
+#else
+        std::FILE* file = std::fopen(path.c_str(), "rb");
+        if (file == nullptr) return std::nullopt;
+        unsigned char chunk[1 << 16];
+        for (size_t n; (n = std::fread(chunk, 1, sizeof(chunk), file)) > 0;) {
+            table.owned_.insert(table.owned_.end(), chunk, chunk + n);
+        }
+        std::fclose(file);
+        table.bytes_ = table.owned_;
+#endif
+        if (!table.parse()) return std::nullopt;
+        return table;
+    }
+
+    // A table over bytes owned by the caller; nullopt if they are not valid
+    static std::optional<prime_table> view(std::span<const unsigned char> bytes) {
+        prime_table table;
+        table.bytes_ = bytes;
+        if (!table.parse()) return std::nullopt;
+        return table;
+    }
+
+    prime_table(prime_table&& other) noexcept { *this = std::move(other); }
+
+    prime_table& operator=(prime_table&& other) noexcept {
+        if (this != &other) {
+            release();
+            bytes_ = std::exchange(other.bytes_, {});
+            mapping_ = std::exchange(other.mapping_, nullptr);
+            owned_ = std::move(other.owned_);
+            lo_ = other.lo_;
+            hi_ = other.hi_;
+            count_ = other.count_;
+            has_two_ = other.has_two_;
+            interval_ = other.interval_;
+            gaps_ = other.gaps_;
+            gap_bytes_ = other.gap_bytes_;
+            checkpoints_ = other.checkpoints_;
+            checkpoint_count_ = other.checkpoint_count_;
+        }
+        return *this;
+    }
+
+    prime_table(const prime_table&) = delete;
+    prime_table& operator=(const prime_table&) = delete;
+    ~prime_table() { release(); }
+
+    uint64_t lo() const { return lo_; }
+    uint64_t hi() const { return hi_; }
+    size_t size() const { return count_; }
+
+    // The i-th prime of the table, i < size(): one checkpoint plus fewer than
+    // K gap decodes
+    uint64_t operator[](size_t i) const {
+        if (has_two_ && i == 0) return 2;
+        i -= has_two_;
+        const size_t j = i / interval_;
+        uint64_t value = checkpoint_prime(j);
+        size_t pos = checkpoint_offset(j);
+        for (size_t r = i % interval_; r > 0; r--) value += detail::read_prime_gap(gaps_, pos, gap_bytes_);
+        return value;
+    }
+
+    // Whether n is prime, for n in [lo, hi)
+    bool is_prime(uint64_t n) const {
+        if (n < lo_ || n >= hi_ || n < 2) return false;
+        if (n % 2 == 0) return n == 2 && has_two_;
+        return lower_bound_odd(n).second == n;
+    }
+
+    // Number of primes of the table below n
+    size_t rank(uint64_t n) const {
+        return (has_two_ && n > 2 ? 1 : 0) + lower_bound_odd(n).first;
+    }
+
+    iterator begin() const {
+        if (count_ == 0) return end();
+        return {this, 0, has_two_ ? 2 : checkpoint_prime(0)};
+    }
+    iterator end() const { return {this, count_, 0}; }
+
+private:
+    prime_table() = default;
+
+    std::span<const unsigned char> bytes_;
+    void* mapping_ = nullptr;
+    std::vector<unsigned char> owned_;
+
+    uint64_t lo_ = 0, hi_ = 0;
+    size_t count_ = 0;
+    bool has_two_ = false;
+    size_t interval_ = 1;
+    const unsigned char* gaps_ = nullptr;
+    size_t gap_bytes_ = 0;
+    const unsigned char* checkpoints_ = nullptr;
+    size_t checkpoint_count_ = 0;
+
+    void release() {
+#if HAS_POSIX_MMAP
+        if (mapping_ != nullptr) ::munmap(mapping_, bytes_.size());
+#endif
+        mapping_ = nullptr;
+    }
+
+    // Checks the header, that every section lies inside the bytes and that
+    // the checkpoints point into the gap stream in order
+    bool parse() {
+        const unsigned char* data = bytes_.data();
+        const uint64_t size = bytes_.size();
+        if (size < detail::prime_table_header_bytes ||
+            !std::equal(std::begin(detail::prime_table_magic), std::end(detail::prime_table_magic), data) ||
+            detail::load_le(data + 8, 4) != detail::prime_table_version) {
+            return false;
+        }
+        interval_ = detail::load_le(data + 12, 4);
+        lo_ = detail::load_le(data + 16, 8);
+        hi_ = detail::load_le(data + 24, 8);
+        count_ = detail::load_le(data + 32, 8);
+        has_two_ = (detail::load_le(data + 40, 8) & detail::prime_table_has_two) != 0;
+        const uint64_t gap_offset = detail::load_le(data + 48, 8);
+        const uint64_t gap_bytes = detail::load_le(data + 56, 8);
+        const uint64_t checkpoints_at = detail::load_le(data + 64, 8);
+        checkpoint_count_ = detail::load_le(data + 72, 8);
+
+        if (interval_ == 0 || count_ < size_t(has_two_)) return false;
+        const uint64_t odd_count = count_ - has_two_;
+        if (checkpoint_count_ != (odd_count + interval_ - 1) / interval_) return false;
+        if (gap_offset > size || gap_bytes > size - gap_offset) return false;
+        if (checkpoints_at > size || checkpoint_count_ > (size - checkpoints_at) / 16) return false;
+        gaps_ = data + gap_offset;
+        gap_bytes_ = gap_bytes;
+        checkpoints_ = data + checkpoints_at;
+        for (size_t j = 0; j < checkpoint_count_; j++) {
+            if (checkpoint_offset(j) > gap_bytes || (j > 0 && checkpoint_offset(j) < checkpoint_offset(j - 1))) return false;
+        }
+        return true;
+    }
+
+    uint64_t checkpoint_prime(size_t j) const { return detail::load_le(checkpoints_ + 16 * j, 8); }
+    size_t checkpoint_offset(size_t j) const { return detail::load_le(checkpoints_ + 16 * j + 8, 8); }
+
+    // Index among the odd primes of the first one >= n, and that prime (0 if
+    // there is none): binary search over checkpoints, then a gap scan
+    std::pair<size_t, uint64_t> lower_bound_odd(uint64_t n) const {
+        size_t a = 0, b = checkpoint_count_;
+        while (a < b) {
+            const size_t mid = a + (b - a) / 2;
+            if (checkpoint_prime(mid) <= n) a = mid + 1; else b = mid;
+        }
+        if (a == 0) return {0, checkpoint_count_ > 0 ? checkpoint_prime(0) : 0};
+
+        const size_t odd_count = count_ - has_two_;
+        size_t k = (a - 1) * interval_;
+        uint64_t value = checkpoint_prime(a - 1);
+        size_t pos = checkpoint_offset(a - 1);
+        while (value < n) {
+            if (++k == odd_count) return {k, 0};
+            value += detail::read_prime_gap(gaps_, pos, gap_bytes_);
+        }
+        return {k, value};
+    }
+};
+
+// ===== Prime bitmap with rank and select =====
+
+namespace detail {
+
+// The eight residues mod 30 coprime to 30; bit r of wheel byte w stands for
+// 30 w + wheel30_residues[r]
+inline constexpr uint8_t wheel30_residues[8] = {1, 7, 11, 13, 17, 19, 23, 29};
+
+// Wheel bit of each residue mod 30, or 8 when it shares a factor with 30
+inline constexpr std::array<uint8_t, 30> wheel30_bit = [] {
+    std::array<uint8_t, 30> bit{};
+    bit.fill(8);
+    for (uint8_t r = 0; r < 8; r++) bit[wheel30_residues[r]] = r;
+    return bit;
+}();
+
+// Number of wheel residues <= m, for m < 30
+inline constexpr std::array<uint8_t, 30> wheel30_rank = [] {
+    std::array<uint8_t, 30> rank{};
+    for (uint8_t m = 0, count = 0; m < 30; m++) rank[m] = count += wheel30_bit[m] < 8;
+    return rank;
+}();
+
+// Position of the r-th set bit of w, r < popcount(w)
+inline unsigned select_in_word(uint64_t w, unsigned r) {
+#if defined(__BMI2__)
+    return static_cast<unsigned>(std::countr_zero(_pdep_u64(uint64_t(1) << r, w)));
+#else
+    for (; r > 0; r--) w &= w - 1;
+    return static_cast<unsigned>(std::countr_zero(w));
+#endif
+}
+
+} // namespace detail
+
+// Succinct index of the primes up to a limit below 7 * 10^12. Primes above 5
+// are bits of a mod-30 wheel, one byte per 30 integers; each 64-byte cache
+// line holds the number of wheel primes before it and 7 bitmap words, so
+// pi(x) reads one line. nth() starts from the line sampled for every 64th
+// prime and steps forward by the line counters, rarely more than one line.
+// The whole index takes about a fifth of the memory of the simd_sieve vector.
+class prime_bitmap {
+public:
+    // The bitmap lines come from resource, e.g. a hugepage_arena
+    explicit prime_bitmap(uint64_t limit, uint32_t thread_count = std::thread::hardware_concurrency(),
+                          std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : limit_(limit), lines_(static_cast<size_t>(limit / LINE_SPAN + 2), resource) {
+        // Each thread sieves whole lines, so no bitmap word is shared
+        const auto base_primes = detail::sieve_base_primes(limit + 1);
+        detail::parallel_for(0, lines_.size(), thread_count, [&](size_t a, size_t b) {
+            const uint64_t hi = std::min<uint64_t>(b * LINE_SPAN, limit + 1);
+            detail::sieve_segments(std::max<uint64_t>(a * LINE_SPAN, 7), hi, base_primes, [&](const sieve_segment& segment) {
+                segment.for_each_prime([&](uint64_t p) {
+                    const uint64_t bit = 8 * (p / 30) + detail::wheel30_bit[p % 30];
+                    lines_[bit / LINE_BITS].words[bit % LINE_BITS / 64] |= uint64_t(1) << (bit % 64);
+                });
+            });
+        });
+
+        for (size_t line = 0; line < lines_.size(); line++) {
+            lines_[line].rank = total_;
+            for (uint64_t w : lines_[line].words) total_ += std::popcount(w);
+            while (samples_.size() * SAMPLE < total_) samples_.push_back(static_cast<uint32_t>(line));
+        }
+    }
+
+    uint64_t limit() const { return limit_; }
+
+    // Number of primes <= x; x beyond the limit counts up to the limit
+    uint64_t pi(uint64_t x) const {
+        x = std::min(x, limit_);
+        if (x < 7) return (x >= 2) + (x >= 3) + (x >= 5);
+        const uint64_t bits = 8 * (x / 30) + detail::wheel30_rank[x % 30];  // wheel bits standing for n <= x
+        const line& l = lines_[bits / LINE_BITS];
+        const size_t within = bits % LINE_BITS;
+        uint64_t count = 3 + l.rank;
+        for (size_t w = 0; w < within / 64; w++) count += std::popcount(l.words[w]);
+        if (within % 64) count += std::popcount(l.words[within / 64] & ((uint64_t(1) << (within % 64)) - 1));
+        return count;
+    }
+
+    // The k-th prime (k = 1 gives 2), or 0 when fewer than k primes lie below the limit
+    uint64_t nth(uint64_t k) const {
+        if (k == 0 || k > 3 + total_) return 0;
+        if (k <= 3) return k == 3 ? 5 : k + 1;
+        const uint64_t index = k - 4;  // among the wheel primes
+        size_t line = samples_[index / SAMPLE];
+        while (line + 1 < lines_.size() && lines_[line + 1].rank <= index) line++;
+
+        uint64_t r = index - lines_[line].rank;
+        for (size_t w = 0;; w++) {
+            const uint64_t word = lines_[line].words[w];
+            const unsigned count = std::popcount(word);
+            if (r < count) {
+                const uint64_t bit = line * LINE_BITS + 64 * w + detail::select_in_word(word, static_cast<unsigned>(r));
+                return 30 * (bit / 8) + detail::wheel30_residues[bit % 8];
+            }
+            r -= count;
+        }
+    }
+
+    // Whether n is prime, for n <= limit
+    bool is_prime(uint64_t n) const {
+        if (n > limit_) return false;
+        if (n < 7) return n == 2 || n == 3 || n == 5;
+        const unsigned r = detail::wheel30_bit[n % 30];
+        if (r == 8) return false;
+        const uint64_t bit = 8 * (n / 30) + r;
+        return (lines_[bit / LINE_BITS].words[bit % LINE_BITS / 64] >> (bit % 64)) & 1;
+    }
+
+    // Bytes held by the bitmap and the select samples
+    size_t memory_bytes() const { return lines_.size() * sizeof(line) + samples_.size() * sizeof(uint32_t); }
+
+private:
+    static constexpr size_t LINE_BITS = 7 * 64;
+    static constexpr uint64_t LINE_SPAN = 30 * LINE_BITS / 8;  // integers per line
+    static constexpr uint64_t SAMPLE = 64;                     // wheel primes per select sample
+
+    struct alignas(64) line {
+        uint64_t rank = 0;  // wheel primes in earlier lines
+        std::array<uint64_t, 7> words{};
+    };
+
+    uint64_t limit_;
+    std::pmr::vector<line> lines_;   // plus a spare, empty line for pi() at a line end
+    std::vector<uint32_t> samples_;  // line holding wheel prime j * SAMPLE
+    uint64_t total_ = 0;             // wheel primes <= limit
+};
+
+// ===== nth prime, next and previous prime =====
+
+namespace detail {
+
+// Li(x) = li(x) - li(2), with li from its series in ln x
+inline long double offset_log_integral(long double x) {
+    constexpr long double euler_gamma = 0.5772156649015328606L;
+    constexpr long double li2 = 1.0451637801174927848L;
+    const long double lx = std::log(x);
+    long double term = 1, sum = 0;
+    for (int k = 1; k < 1000; k++) {
+        term *= lx / k;
+        const long double next = sum + term / k;
+        if (next == sum) break;
+        sum = next;
+    }
+    return euler_gamma + std::log(lx) + sum - li2;
+}
+
+// x with Li(x) = n, by Newton's method on Li'(x) = 1 / ln x
+inline uint64_t inverse_log_integral(uint64_t n) {
+    long double x = n * std::log(static_cast<long double>(n));
+    for (int i = 0; i < 50; i++) {
+        const long double step = (offset_log_integral(x) - n) * std::log(x);
+        x -= step;
+        if (std::fabs(step) < 1) break;
+    }
+    return x < 1.8e19L ? static_cast<uint64_t>(x) : UINT64_MAX;
+}
+
+// Odd candidates first, first + 2, ... per window of next_prime and
+// prev_prime, and the bound on the primes that sieve them
+inline constexpr size_t prime_window_odds = 64;
+inline constexpr uint32_t window_prime_bound = 256;
+
+// An odd sieving prime with Lemire's constant M = ceil(2^64 / p), so that
+// a mod p = ((M a mod 2^64) p) >> 64 for any 32-bit a without a division
+struct window_prime {
+    uint32_t p;
+    uint32_t two32;  // 2^32 mod p
+    uint64_t M;
+
+    uint32_t mod(uint32_t a) const { return static_cast<uint32_t>((static_cast<unsigned __int128>(M * a) * p) >> 64); }
+};
+
+// The odd primes below window_prime_bound: dividing these out leaves about
+// one odd candidate in five for Miller-Rabin
+inline const std::vector<window_prime>& window_sieve_primes() {
+    static const std::vector<window_prime> primes = [] {
+        std::vector<window_prime> primes;
+        for (uint32_t p : simd_sieve(window_prime_bound)) {
+            if (p > 2) primes.push_back({p, static_cast<uint32_t>((uint64_t(1) << 32) % p), UINT64_MAX / p + 1});
+        }
+        return primes;
+    }();
+    return primes;
+}
+
+// Bit i set when first + 2 i (first odd) has no odd prime factor in the
+// window sieve other than itself
+inline std::array<uint64_t, prime_window_odds / 64> window_survivors(uint64_t first) {
+    std::array<uint64_t, prime_window_odds / 64> bits;
+    bits.fill(~uint64_t(0));
+    const uint32_t hi = static_cast<uint32_t>(first >> 32), lo = static_cast<uint32_t>(first);
+    for (const window_prime& q : window_sieve_primes()) {
+        // first + 2 i = 0 mod p at i = -first / 2 mod p
+        const uint32_t r = q.mod(q.mod(hi) * q.two32 + q.mod(lo));
+        size_t i = q.mod((r == 0 ? 0 : q.p - r) * ((q.p + 1) / 2));
+        if (first + 2 * i == q.p) i += q.p;
+        for (; i < prime_window_odds; i += q.p) bits[i / 64] &= ~(uint64_t(1) << (i % 64));
+    }
+    return bits;
+}
+
+// The k-th prime > x (k >= 1), sieving upward through windows that double
+// in size, so a near miss costs a short sieve and a far one stays linear
+inline uint64_t nth_prime_above(uint64_t x, uint64_t k) {
+    std::vector<uint64_t> primes;
+    for (uint64_t lo = x + 1, window = uint64_t(1) << 16;; lo += window, window *= 2) {
+        primes.clear();
+        for_each_prime(lo, lo + window, [&](uint64_t p) { primes.push_back(p); });
+        if (k <= primes.size()) return primes[k - 1];
+        k -= primes.size();
+    }
+}
+
+// The k-th prime <= x counting down (k >= 1, at least k primes <= x)
+inline uint64_t nth_prime_at_or_below(uint64_t x, uint64_t k) {
+    std::vector<uint64_t> primes;
+    for (uint64_t hi = x + 1, window = uint64_t(1) << 16;; hi -= window, window *= 2) {
+        window = std::min(window, hi);
+        primes.clear();
+        for_each_prime(hi - window, hi, [&](uint64_t p) { primes.push_back(p); });
+        if (k <= primes.size()) return primes[primes.size() - k];
+        k -= primes.size();
+    }
+}
+
+} // namespace detail
+
+// The n-th prime (n = 1 gives 2), for n below about 10^12. Li^-1(n) lands
+// a little below the answer, since Li(x) > pi(x) across the 64-bit range;
+// the exact pi(x) there says how many primes a short segmented sieve walks
+// up, or down should the estimate ever overshoot.
+inline uint64_t nth_prime(uint64_t n, uint32_t thread_count = std::thread::hardware_concurrency()) {
+    if (n == 0) return 0;
+    if (n < 10000) return detail::nth_prime_above(0, n);
+    const uint64_t x = detail::inverse_log_integral(n);
+    const uint64_t count = prime_count(x, thread_count);
+    return count >= n ? detail::nth_prime_at_or_below(x, count - n + 1) : detail::nth_prime_above(x, n - count);
+}
+
+// Smallest prime > x, or 0 past the largest 64-bit prime. Each window of
+// odd candidates is sieved by the primes below 256 before Miller-Rabin,
+// which then skips the trial division of is_probable_prime.
+inline uint64_t next_prime(uint64_t x) {
+    if (x < 2) return 2;
+    if (x >= 18446744073709551557ULL) return 0;
+    for (uint64_t first = (x + 1) | 1;; first += 2 * detail::prime_window_odds) {
+        const auto bits = detail::window_survivors(first);
+        for (size_t w = 0; w < bits.size(); w++) {
+            for (uint64_t b = bits[w]; b != 0; b &= b - 1) {
+                const uint64_t n = first + 2 * (64 * w + std::countr_zero(b));
+                if (n < uint64_t(detail::window_prime_bound) * detail::window_prime_bound || detail::miller_rabin_64(n)) return n;
+            }
+        }
+    }
+}
+
+// Largest prime < x, or 0 when x <= 2
+inline uint64_t prev_prime(uint64_t x) {
+    if (x <= 3) return x == 3 ? 2 : 0;
+    constexpr uint64_t SPAN = 2 * (detail::prime_window_odds - 1);
+    for (uint64_t last = (x - 2) | 1;; last -= SPAN + 2) {
+        // A window ending at last, clipped so its first candidate is >= 3
+        const uint64_t first = last >= SPAN + 3 ? last - SPAN : 3;
+        const auto bits = detail::window_survivors(first);
+        for (size_t i = static_cast<size_t>((last - first) / 2) + 1; i-- > 0;) {
+            const uint64_t n = first + 2 * i;
+            if ((bits[i / 64] >> (i % 64)) & 1 && (n < uint64_t(detail::window_prime_bound) * detail::window_prime_bound || detail::miller_rabin_64(n))) return n;
+        }
+    }
+}
+
+// ===== Batched modular exponentiation =====
+
+namespace detail {
+
+// Montgomery arithmetic mod an odd n < 2^32 with R = 2^32, on values kept
+// in 64-bit lanes so products fit vpmuludq. n_inv is -n^-1 mod 2^32.
+struct mont32 {
+    uint64_t n;
+    uint64_t n_inv;
+
+    explicit mont32(uint32_t modulus) : n(modulus), n_inv(0) {
+        uint32_t inv = modulus;
+        for (int i = 0; i < 4; i++) inv *= 2 - modulus * inv;
+        n_inv = uint32_t(0) - inv;
+    }
+
+    // t / R mod n for t < n R: t + q n is divisible by R and below 2 n R
+    uint64_t reduce(uint64_t t) const {
+        const uint64_t q = uint32_t(uint32_t(t) * n_inv);
+        const uint64_t r = (t >> 32) + ((t % (uint64_t(1) << 32) + q * n) >> 32);
+        return r >= n ? r - n : r;
+    }
+    uint64_t to(uint64_t a) const { return ((a % n) << 32) % n; }
+};
+
+// Square-and-multiply over Lanes exponents in lockstep, from the top bit of
+// the longest one. Every lane squares at every bit and multiplies by the
+// table entry for its next 4-bit window (x^0 = 1 included), so a shorter
+// exponent only sees leading zeros and no lane branches. Lanes are
+// interleaved so independent multiplies overlap in the pipeline.
+template <size_t Lanes>
+void modpow_lanes(const montgomery<uint64_t>& mont, const uint64_t* bases, const uint64_t* exps, uint64_t* out) {
+    uint64_t powers[Lanes][16], r[Lanes], top = 0;
+    for (size_t l = 0; l < Lanes; l++) {
+        powers[l][0] = mont.one();
+        powers[l][1] = mont.to(bases[l]);
+        r[l] = mont.one();
+        top |= exps[l];
+    }
+    for (size_t j = 2; j < 16; j++) {
+        for (size_t l = 0; l < Lanes; l++) powers[l][j] = mont.mul(powers[l][j - 1], powers[l][1]);
+    }
+    for (unsigned bit = (std::bit_width(top) + 3) / 4 * 4; bit > 0;) {
+        bit -= 4;
+        for (size_t l = 0; l < Lanes; l++) {
+            for (int s = 0; s < 4; s++) r[l] = mont.mul(r[l], r[l]);
+            r[l] = mont.mul(r[l], powers[l][(exps[l] >> bit) & 15]);
+        }
+    }
+    for (size_t l = 0; l < Lanes; l++) out[l] = mont.from(r[l]);
+}
+
+#if defined(__AVX512F__)
+// mont32::reduce(a b) in each 64-bit lane; the low halves of t and q n sum
+// to 0 or R. Zero-masked forms throughout: GCC 12 flags the undefined
+// source operand of the unmasked ones as maybe-uninitialized once inlined.
+inline __m512i mont32_mul_x8(__m512i a, __m512i b, __m512i n, __m512i n_inv) {
+    constexpr __mmask8 all = 0xff;
+    const __m512i low = _mm512_set1_epi64(0xffffffff);
+    const __m512i t = _mm512_maskz_mul_epu32(all, a, b);
+    const __m512i qn = _mm512_maskz_mul_epu32(all, _mm512_maskz_mul_epu32(all, t, n_inv), n);
+    const __m512i carry = _mm512_maskz_srli_epi64(all, _mm512_add_epi64(_mm512_and_si512(t, low), _mm512_and_si512(qn, low)), 32);
+    const __m512i s = _mm512_add_epi64(_mm512_add_epi64(_mm512_maskz_srli_epi64(all, t, 32), _mm512_maskz_srli_epi64(all, qn, 32)), carry);
+    return _mm512_maskz_min_epu64(all, s, _mm512_sub_epi64(s, n));
+}
+
+// Square-and-multiply for n < 2^32 on two 8-lane vectors, each lane taking
+// its multiply under its exponent bit; bases and results in Montgomery form.
+// (AVX2's 4 + 4 lanes did not beat the scalar lanes, so it has no kernel.)
+inline constexpr size_t modpow_vector_lanes = 16;
+
+inline void modpow_lanes32(const mont32& mont, const uint64_t* bases, const uint64_t* exps, uint64_t* out) {
+    const __m512i n = _mm512_set1_epi64(static_cast<long long>(mont.n));
+    const __m512i n_inv = _mm512_set1_epi64(static_cast<long long>(mont.n_inv));
+    const __m512i x0 = _mm512_loadu_si512(bases), x1 = _mm512_loadu_si512(bases + 8);
+    const __m512i e0 = _mm512_loadu_si512(exps), e1 = _mm512_loadu_si512(exps + 8);
+    __m512i r0 = _mm512_set1_epi64(static_cast<long long>(mont.to(1))), r1 = r0;
+    uint64_t top = 0;
+    for (size_t l = 0; l < modpow_vector_lanes; l++) top |= exps[l];
+    for (unsigned bit = std::bit_width(top); bit-- > 0;) {
+        const __m512i mask = _mm512_set1_epi64(static_cast<long long>(uint64_t(1) << bit));
+        r0 = mont32_mul_x8(r0, r0, n, n_inv);
+        r1 = mont32_mul_x8(r1, r1, n, n_inv);
+        r0 = _mm512_mask_blend_epi64(_mm512_test_epi64_mask(e0, mask), r0, mont32_mul_x8(r0, x0, n, n_inv));
+        r1 = _mm512_mask_blend_epi64(_mm512_test_epi64_mask(e1, mask), r1, mont32_mul_x8(r1, x1, n, n_inv));
+    }
+    _mm512_storeu_si512(out, r0);
+    _mm512_storeu_si512(out + 8, r1);
+}
+#endif
+
+} // namespace detail
+
+// out[i] = bases[i]^exps[i] mod m for each i below out.size(); a bases or
+// exps span of size 1 is used for every i, a longer one must match out and
+// a shorter one stops the batch. Returns how many results were written.
+// Odd moduli run Montgomery exponentiation in lockstep across lanes: 16 per
+// AVX-512 vector step below 2^32, otherwise 4 interleaved scalar lanes with
+// 4-bit windows; even moduli fall back to modpow.
+inline size_t modpow_batch(std::span<const uint64_t> bases, std::span<const uint64_t> exps, uint64_t m,
+                           std::span<uint64_t> out) {
+    size_t count = out.size();
+    if (bases.size() != 1) count = std::min(count, bases.size());
+    if (exps.size() != 1) count = std::min(count, exps.size());
+    if (bases.empty() || exps.empty() || m == 0) return 0;
+    auto base_at = [&](size_t i) { return bases[bases.size() == 1 ? 0 : i]; };
+    auto exp_at = [&](size_t i) { return exps[exps.size() == 1 ? 0 : i]; };
+    if (m == 1 || m % 2 == 0) {
+        for (size_t i = 0; i < count; i++) out[i] = modpow<uint64_t>(base_at(i), exp_at(i), m);
+        return count;
+    }
+
+    // Groups of lanes read the inputs in place; broadcasts and the tail,
+    // padded with x^0, go through a copy
+    auto run = [&](size_t lanes, auto&& kernel) {
+        uint64_t b[16] = {}, e[16] = {}, r[16] = {};
+        for (size_t i = 0; i < count; i += lanes) {
+            const size_t n = std::min(lanes, count - i);
+            if (n == lanes && bases.size() != 1 && exps.size() != 1) {
+                kernel(bases.data() + i, exps.data() + i, r);
+            } else {
+                for (size_t l = 0; l < lanes; l++) {
+                    b[l] = l < n ? base_at(i + l) : 1;
+                    e[l] = l < n ? exp_at(i + l) : 0;
+                }
+                kernel(b, e, r);
+            }
+            std::copy_n(r, n, out.begin() + i);
+        }
+    };
+#if defined(__AVX512F__)
+    if (m < (uint64_t(1) << 32)) {
+        const detail::mont32 mont(static_cast<uint32_t>(m));
+        run(detail::modpow_vector_lanes, [&](const uint64_t* b, const uint64_t* e, uint64_t* r) {
+            uint64_t x[detail::modpow_vector_lanes];
+            for (size_t l = 0; l < detail::modpow_vector_lanes; l++) x[l] = mont.to(b[l]);
+            detail::modpow_lanes32(mont, x, e, r);
+            for (size_t l = 0; l < detail::modpow_vector_lanes; l++) r[l] = mont.reduce(r[l]);
+        });
+        return count;
+    }
+#endif
+    const montgomery<uint64_t> mont(m);
+    run(4, [&](const uint64_t* b, const uint64_t* e, uint64_t* r) { detail::modpow_lanes<4>(mont, b, e, r); });
+    return count;
+}
+
+// ===== Simultaneous multi-exponentiation =====
+
+namespace detail {
+
+// Residues mod an even m with montgomery<T>'s interface, by plain mulmod
+struct plain_mod {
+    uint64_t m;
+    uint64_t one() const { return 1 % m; }
+    uint64_t to(uint64_t a) const { return a % m; }
+    uint64_t from(uint64_t a) const { return a; }
+    uint64_t mul(uint64_t a, uint64_t b) const { return mulmod(a, b, m); }
+};
+
+// Multiplications for max_bits-bit exponents over k terms: Straus with
+// w-bit windows (tables of 2^w - 2 products per term), and Pippenger with
+// c-bit windows (a product per term and two per bucket each window)
+inline uint64_t straus_cost(size_t k, unsigned max_bits, unsigned w) {
+    return max_bits + k * ((uint64_t(1) << w) - 2) + k * ((max_bits + w - 1) / w);
+}
+inline uint64_t pippenger_cost(size_t k, unsigned max_bits, unsigned c) {
+    return max_bits + (max_bits + c - 1) / c * (k + (uint64_t(2) << c));
+}
+
+// Straus interleaving: one shared run of squarings, then per window a
+// multiply by each term's table entry for its digit
+template <typename Mod>
+uint64_t straus_modpow(const Mod& mod, std::span<const std::pair<uint64_t, uint64_t>> terms, unsigned max_bits, unsigned w) {
+    const size_t size = size_t(1) << w;
+    uint64_t local[256];  // a few terms' tables without allocating
+    std::vector<uint64_t> heap(terms.size() * size > 256 ? terms.size() * size : 0);
+    uint64_t* const table = heap.empty() ? local : heap.data();
+    for (size_t i = 0; i < terms.size(); i++) {
+        uint64_t* powers = table + i * size;
+        powers[0] = mod.one();
+        powers[1] = mod.to(terms[i].first);
+        for (size_t j = 2; j < size; j++) powers[j] = mod.mul(powers[j - 1], powers[1]);
+    }
+    uint64_t acc = mod.one();
+    for (unsigned bit = (max_bits + w - 1) / w * w; bit > 0;) {
+        bit -= w;
+        for (unsigned s = 0; s < w; s++) acc = mod.mul(acc, acc);
+        for (size_t i = 0; i < terms.size(); i++) {
+            const size_t digit = static_cast<size_t>((terms[i].second >> bit) & (size - 1));
+            if (digit != 0) acc = mod.mul(acc, table[i * size + digit]);
+        }
+    }
+    return mod.from(acc);
+}
+
+// Pippenger's buckets: per window each base joins the bucket of its digit,
+// and prod_d B_d^d comes from two running products over the buckets
+template <typename Mod>
+uint64_t pippenger_modpow(const Mod& mod, std::span<const std::pair<uint64_t, uint64_t>> terms, unsigned max_bits, unsigned c) {
+    std::vector<uint64_t> bases(terms.size());
+    for (size_t i = 0; i < terms.size(); i++) bases[i] = mod.to(terms[i].first);
+    std::vector<uint64_t> buckets(size_t(1) << c);
+    uint64_t acc = mod.one();
+    for (unsigned bit = (max_bits + c - 1) / c * c; bit > 0;) {
+        bit -= c;
+        for (unsigned s = 0; s < c; s++) acc = mod.mul(acc, acc);
+        std::fill(buckets.begin(), buckets.end(), mod.one());
+        for (size_t i = 0; i < terms.size(); i++) {
+            const size_t digit = static_cast<size_t>((terms[i].second >> bit) & (buckets.size() - 1));
+            if (digit != 0) buckets[digit] = mod.mul(buckets[digit], bases[i]);
+        }
+        uint64_t running = mod.one(), window = mod.one();
+        for (size_t d = buckets.size() - 1; d > 0; d--) {
+            running = mod.mul(running, buckets[d]);
+            window = mod.mul(window, running);
+        }
+        acc = mod.mul(acc, window);
+    }
+    return mod.from(acc);
+}
+
+// The cheaper method and window for these terms
+template <typename Mod>
+uint64_t multi_modpow_with(const Mod& mod, std::span<const std::pair<uint64_t, uint64_t>> terms) {
+    uint64_t all = 0;
+    for (const auto& term : terms) all |= term.second;
+    const unsigned max_bits = std::bit_width(all);
+    if (max_bits == 0) return mod.from(mod.one());
+    unsigned w = 1, c = 1;
+    for (unsigned x = 2; x <= 8; x++) {
+        if (straus_cost(terms.size(), max_bits, x) < straus_cost(terms.size(), max_bits, w)) w = x;
+    }
+    for (unsigned x = 2; x <= 16; x++) {
+        if (pippenger_cost(terms.size(), max_bits, x) < pippenger_cost(terms.size(), max_bits, c)) c = x;
+    }
+    if (pippenger_cost(terms.size(), max_bits, c) < straus_cost(terms.size(), max_bits, w)) {
+        return pippenger_modpow(mod, terms, max_bits, c);
+    }
+    return straus_modpow(mod, terms, max_bits, w);
+}
+
+} // namespace detail
+
+// prod g_i^e_i mod m over the (g_i, e_i) terms, sharing one run of
+// squarings: Straus interleaving with fixed windows for a few terms,
+// Pippenger's bucket method for many, whichever needs fewer
+// multiplications. Montgomery arithmetic for odd m; 0 when m is 0.
+inline uint64_t multi_modpow(std::span<const std::pair<uint64_t, uint64_t>> terms, uint64_t m) {
+    if (m == 0) return 0;
+    if (m % 2 == 0) return detail::multi_modpow_with(detail::plain_mod{m}, terms);
+    if (m == 1) return 0;
+    return detail::multi_modpow_with(montgomery<uint64_t>(m), terms);
+}
+
+inline uint64_t multi_modpow(std::initializer_list<std::pair<uint64_t, uint64_t>> terms, uint64_t m) {
+    return multi_modpow(std::span<const std::pair<uint64_t, uint64_t>>(terms.begin(), terms.size()), m);
+}
+
+// ===== Matrices over Z/pZ =====
+
+namespace detail {
+
+// Columns of b per packed panel and rows of a per block in mat_mod_multiply:
+// a block's 128-bit sums (16 KiB) stay in L1, a panel (n KiB) in L2
+constexpr size_t mat_mod_panel_columns = 256;
+constexpr size_t mat_mod_block_rows = 4;
+
+// Products of entries below P that a 64-bit sum holds without overflowing
+template <uint32_t P>
+constexpr size_t mat_mod_lazy_terms() {
+    const uint64_t square = uint64_t(P - 1) * (P - 1);
+    return square <= 1 ? size_t(1) << 20 : static_cast<size_t>(std::min<uint64_t>(UINT64_MAX / square, 1 << 20));
+}
+
+// Buffers for mat_mod_multiply, reused across the steps of a power
+struct mat_mod_scratch {
+    std::vector<uint32_t> panel;
+    std::vector<uint64_t> sum, lo, hi;
+};
+
+// One mat_mod_block_rows x mat_mod_tile_columns tile of a b over all n
+// terms, with a k-major packed b: 64-bit sums of lazy products at a time
+// in registers, each folded into the 128-bit lo/hi pair with a carry. The
+// entries are below 2^32, so each product is a single vpmuludq.
+#if defined(__AVX512F__)
+inline constexpr size_t mat_mod_tile_columns = 16;
+
+inline void mat_mod_tile(const uint32_t* a, size_t n, const uint32_t* b, size_t lazy, uint64_t* lo, uint64_t* hi, size_t stride) {
+    constexpr __mmask8 all = 0xff;  // zero-masked forms, as in mont32_mul_x8
+    const __m512i one = _mm512_set1_epi64(1);
+    __m512i acc[mat_mod_block_rows][2], l[mat_mod_block_rows][2], h[mat_mod_block_rows][2];
+    for (size_t r = 0; r < mat_mod_block_rows; r++) {
+        for (size_t c = 0; c < 2; c++) l[r][c] = h[r][c] = _mm512_setzero_si512();
+    }
+    for (size_t k0 = 0; k0 < n; k0 += lazy) {
+        for (auto& row : acc) row[0] = row[1] = _mm512_setzero_si512();
+        for (size_t k = k0; k < std::min(n, k0 + lazy); k++) {
+            const uint32_t* const b_row = b + k * mat_mod_tile_columns;
+            const __m512i b0 = _mm512_maskz_cvtepu32_epi64(all, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b_row)));
+            const __m512i b1 = _mm512_maskz_cvtepu32_epi64(all, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b_row + 8)));
+            for (size_t r = 0; r < mat_mod_block_rows; r++) {
+                const __m512i x = _mm512_set1_epi64(a[r * n + k]);
+                acc[r][0] = _mm512_add_epi64(acc[r][0], _mm512_maskz_mul_epu32(all, x, b0));
+                acc[r][1] = _mm512_add_epi64(acc[r][1], _mm512_maskz_mul_epu32(all, x, b1));
+            }
+        }
+        for (size_t r = 0; r < mat_mod_block_rows; r++) {
+            for (size_t c = 0; c < 2; c++) {
+                l[r][c] = _mm512_add_epi64(l[r][c], acc[r][c]);
+                h[r][c] = _mm512_mask_add_epi64(h[r][c], _mm512_cmplt_epu64_mask(l[r][c], acc[r][c]), h[r][c], one);
+            }
+        }
+    }
+    for (size_t r = 0; r < mat_mod_block_rows; r++) {
+        for (size_t c = 0; c < 2; c++) {
+            _mm512_storeu_si512(lo + r * stride + 8 * c, l[r][c]);
+            _mm512_storeu_si512(hi + r * stride + 8 * c, h[r][c]);
+        }
+    }
+}
+#elif defined(__AVX2__)
+inline constexpr size_t mat_mod_tile_columns = 8;
+
+inline void mat_mod_tile(const uint32_t* a, size_t n, const uint32_t* b, size_t lazy, uint64_t* lo, uint64_t* hi, size_t stride) {
+    // AVX2 compares signed lanes only: flipping the sign bits orders them unsigned
+    const __m256i sign = _mm256_set1_epi64x(INT64_MIN);
+    __m256i acc[mat_mod_block_rows][2], l[mat_mod_block_rows][2], h[mat_mod_block_rows][2];
+    for (size_t r = 0; r < mat_mod_block_rows; r++) {
+        for (size_t c = 0; c < 2; c++) l[r][c] = h[r][c] = _mm256_setzero_si256();
+    }
+    for (size_t k0 = 0; k0 < n; k0 += lazy) {
+        for (auto& row : acc) row[0] = row[1] = _mm256_setzero_si256();
+        for (size_t k = k0; k < std::min(n, k0 + lazy); k++) {
+            const uint32_t* const b_row = b + k * mat_mod_tile_columns;
+            const __m256i b0 = _mm256_cvtepu32_epi64(_mm_loadu_si128(reinterpret_cast<const __m128i*>(b_row)));
+            const __m256i b1 = _mm256_cvtepu32_epi64(_mm_loadu_si128(reinterpret_cast<const __m128i*>(b_row + 4)));
+            for (size_t r = 0; r < mat_mod_block_rows; r++) {
+                const __m256i x = _mm256_set1_epi64x(a[r * n + k]);
+                acc[r][0] = _mm256_add_epi64(acc[r][0], _mm256_mul_epu32(x, b0));
+                acc[r][1] = _mm256_add_epi64(acc[r][1], _mm256_mul_epu32(x, b1));
+            }
+        }
+        for (size_t r = 0; r < mat_mod_block_rows; r++) {
+            for (size_t c = 0; c < 2; c++) {
+                l[r][c] = _mm256_add_epi64(l[r][c], acc[r][c]);
+                const __m256i carry = _mm256_cmpgt_epi64(_mm256_xor_si256(acc[r][c], sign), _mm256_xor_si256(l[r][c], sign));
+                h[r][c] = _mm256_sub_epi64(h[r][c], carry);
+            }
+        }
+    }
+    for (size_t r = 0; r < mat_mod_block_rows; r++) {
+        for (size_t c = 0; c < 2; c++) {
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(lo + r * stride + 4 * c), l[r][c]);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(hi + r * stride + 4 * c), h[r][c]);
+        }
+    }
+}
+#else
+inline constexpr size_t mat_mod_tile_columns = 8;
+
+inline void mat_mod_tile(const uint32_t* a, size_t n, const uint32_t* b, size_t lazy, uint64_t* lo, uint64_t* hi, size_t stride) {
+    constexpr size_t R = mat_mod_block_rows, V = mat_mod_tile_columns;
+    uint64_t l[R][V] = {}, h[R][V] = {};
+    for (size_t k0 = 0; k0 < n; k0 += lazy) {
+        uint64_t acc[R][V] = {};
+        for (size_t k = k0; k < std::min(n, k0 + lazy); k++) {
+            for (size_t r = 0; r < R; r++) {
+                const uint64_t x = a[r * n + k];
+                for (size_t v = 0; v < V; v++) acc[r][v] += x * b[k * V + v];
+            }
+        }
+        for (size_t r = 0; r < R; r++) {
+            for (size_t v = 0; v < V; v++) {
+                l[r][v] += acc[r][v];
+                h[r][v] += l[r][v] < acc[r][v];
+            }
+        }
+    }
+    for (size_t r = 0; r < R; r++) {
+        std::copy_n(l[r], V, lo + r * stride);
+        std::copy_n(h[r], V, hi + r * stride);
+    }
+}
+#endif
+
+// c = a b for n x n row-major matrices with entries below P; c must not
+// alias a or b. Each column panel of b is packed once, then every block of
+// rows of a sweeps it in register tiles, so each entry of c costs plain
+// 64-bit multiply-adds, a carry every mat_mod_lazy_terms products and one
+// reduction mod P at the end.
+template <uint32_t P>
+void mat_mod_multiply(size_t n, const uint32_t* a, const uint32_t* b, uint32_t* c, mat_mod_scratch& scratch) {
+    constexpr size_t W = mat_mod_panel_columns, R = mat_mod_block_rows, V = mat_mod_tile_columns;
+    constexpr size_t lazy = mat_mod_lazy_terms<P>();
+    constexpr uint64_t r64 = (UINT64_MAX % P + 1) % P;  // 2^64 mod P
+    scratch.panel.resize(n * W);
+    scratch.sum.resize(W);
+    scratch.lo.resize(R * W);
+    scratch.hi.resize(R * W);
+    uint32_t* const panel = scratch.panel.data();
+    uint64_t* const sum = scratch.sum.data();
+    uint64_t* const lo = scratch.lo.data();
+    uint64_t* const hi = scratch.hi.data();
+
+    for (size_t j0 = 0; j0 < n; j0 += W) {
+        const size_t w = std::min(W, n - j0);
+        const size_t tiles = w / V;
+        // Whole tiles of the panel, each k-major and contiguous
+        for (size_t k = 0; k < n; k++) {
+            for (size_t tile = 0; tile < tiles; tile++) {
+                std::copy_n(b + k * n + j0 + tile * V, V, panel + (tile * n + k) * V);
+            }
+        }
+        for (size_t i0 = 0; i0 < n; i0 += R) {
+            const size_t rows = std::min(R, n - i0);
+            const size_t tiled = rows == R ? tiles * V : 0;
+            for (size_t j = 0; j < tiled; j += V) mat_mod_tile(a + i0 * n, n, panel + j * n, lazy, lo + j, hi + j, W);
+
+            // Ragged right and bottom edges, a row at a time
+            for (size_t r = 0; r < rows; r++) {
+                std::fill(lo + r * W + tiled, lo + r * W + w, 0);
+                std::fill(hi + r * W + tiled, hi + r * W + w, 0);
+                for (size_t k0 = 0; k0 < n; k0 += lazy) {
+                    std::fill(sum + tiled, sum + w, 0);
+                    for (size_t k = k0; k < std::min(n, k0 + lazy); k++) {
+                        const uint64_t x = a[(i0 + r) * n + k];
+                        for (size_t j = tiled; j < w; j++) sum[j] += x * b[k * n + j0 + j];
+                    }
+                    for (size_t j = tiled; j < w; j++) {
+                        lo[r * W + j] += sum[j];
+                        hi[r * W + j] += lo[r * W + j] < sum[j];
+                    }
+                }
+            }
+
+            for (size_t r = 0; r < rows; r++) {
+                for (size_t j = 0; j < w; j++) {
+                    const size_t t = r * W + j;
+                    c[(i0 + r) * n + j0 + j] = static_cast<uint32_t>((hi[t] % P * r64 % P + lo[t] % P) % P);
+                }
+            }
+        }
+    }
+}
+
+} // namespace detail
+
+// n x n matrix over Z/PZ, row-major with entries in [0, P). Products use a
+// cache-tiled kernel with lazy reduction; powers reuse three buffers.
+template <uint32_t P = 998244353>
+class mat_mod {
+    static_assert(P > 1, "Modulus must be at least 2");
+    size_t n_ = 0;
+    std::vector<uint32_t> a_;
+
+public:
+    mat_mod() = default;
+    explicit mat_mod(size_t n) : n_(n), a_(n * n, 0) {}
+
+    // From n * n row-major entries, reduced mod P; missing entries are zero
+    mat_mod(size_t n, std::vector<uint32_t> entries) : n_(n), a_(std::move(entries)) {
+        a_.resize(n * n, 0);
+        for (auto& x : a_) x %= P;
+    }
+
+    // From rows, as {{a, b}, {c, d}}; the row count is the size
+    mat_mod(std::initializer_list<std::initializer_list<uint32_t>> rows) : mat_mod(rows.size()) {
+        size_t i = 0;
+        for (const auto& row : rows) {
+            size_t j = 0;
+            for (uint32_t x : row) {
+                if (j < n_) a_[i * n_ + j] = x % P;
+                j++;
+            }
+            i++;
+        }
+    }
+
+    static mat_mod identity(size_t n) {
+        mat_mod m(n);
+        for (size_t i = 0; i < n; i++) m.a_[i * n + i] = 1 % P;
+        return m;
+    }
+
+    size_t size() const { return n_; }
+    uint32_t operator()(size_t i, size_t j) const { return a_[i * n_ + j]; }
+    void set(size_t i, size_t j, uint32_t x) { a_[i * n_ + j] = x % P; }
+    std::span<const uint32_t> entries() const { return a_; }
+
+    // a b into out, resized to match, through caller-owned scratch; out must
+    // not be a or b. Empty when the sizes differ.
+    static void multiply(const mat_mod& a, const mat_mod& b, mat_mod& out, detail::mat_mod_scratch& scratch) {
+        const size_t n = a.n_ == b.n_ ? a.n_ : 0;
+        out.n_ = n;
+        out.a_.resize(n * n);
+        detail::mat_mod_multiply<P>(n, a.a_.data(), b.a_.data(), out.a_.data(), scratch);
+    }
+
+    // M^e by squaring; the steps ping-pong between preallocated buffers
+    mat_mod pow(uint64_t e) const {
+        mat_mod result = identity(n_), base = *this, next(n_);
+        detail::mat_mod_scratch scratch;
+        for (; e > 0; e >>= 1) {
+            if (e & 1) {
+                multiply(result, base, next, scratch);
+                std::swap(result, next);
+            }
+            if (e > 1) {
+                multiply(base, base, next, scratch);
+                std::swap(base, next);
+            }
+        }
+        return result;
+    }
+
+    // M v for a vector of n entries below P; empty when the sizes differ
+    std::vector<uint32_t> apply(std::span<const uint32_t> v) const {
+        if (v.size() != n_) return {};
+        std::vector<uint32_t> r(n_);
+        for (size_t i = 0; i < n_; i++) {
+            unsigned __int128 s = 0;
+            for (size_t j = 0; j < n_; j++) s += uint64_t(a_[i * n_ + j]) * (v[j] % P);
+            r[i] = static_cast<uint32_t>(s % P);
+        }
+        return r;
+    }
+
+    friend bool operator==(const mat_mod&, const mat_mod&) = default;
+
+    friend mat_mod operator+(const mat_mod& a, const mat_mod& b) {
+        if (a.n_ != b.n_) return mat_mod();
+        mat_mod r(a.n_);
+        for (size_t t = 0; t < r.a_.size(); t++) r.a_[t] = static_cast<uint32_t>((uint64_t(a.a_[t]) + b.a_[t]) % P);
+        return r;
+    }
+
+    friend mat_mod operator-(const mat_mod& a, const mat_mod& b) {
+        if (a.n_ != b.n_) return mat_mod();
+        mat_mod r(a.n_);
+        for (size_t t = 0; t < r.a_.size(); t++) r.a_[t] = static_cast<uint32_t>((uint64_t(a.a_[t]) + P - b.a_[t]) % P);
+        return r;
+    }
+
+    friend mat_mod operator*(const mat_mod& a, const mat_mod& b) {
+        mat_mod r;
+        detail::mat_mod_scratch scratch;
+        multiply(a, b, r, scratch);
+        return r;
+    }
+};
+
 } // namespace CNTCL
\ No newline at end of file
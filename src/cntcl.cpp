@@ -0,0 +1,233 @@
+// cntcl.cpp - Command-line batch queries over the CNTCL library
+//
+//   cntcl <isprime|factor|phi|next_prime> [--binary] [--threads N] [file]
+//
+// Reads whitespace-separated decimal integers, or little-endian uint64
+// values with --binary, from the file (memory-mapped) or from stdin, and
+// prints one "n: result" line per input in input order.
+#include "CNTCL.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace {
+
+enum class query { isprime, factor, phi, next_prime };
+
+// Bytes of input handed to one worker at a time
+constexpr size_t BLOCK_BYTES = size_t(1) << 22;
+
+void append_number(std::string& out, uint64_t n) {
+    char digits[24];
+    const auto end = std::to_chars(digits, digits + sizeof(digits), n).ptr;
+    out.append(digits, end);
+}
+
+void answer(query q, uint64_t n, std::string& out) {
+    append_number(out, n);
+    out += ':';
+    switch (q) {
+    case query::isprime:
+        out += CNTCL::is_probable_prime(n) ? " 1" : " 0";
+        break;
+    case query::factor:
+        if (n > 1) {
+            for (uint64_t p : CNTCL::prime_factors(n)) {
+                out += ' ';
+                append_number(out, p);
+            }
+        }
+        break;
+    case query::phi:
+        out += ' ';
+        append_number(out, CNTCL::euler_phi(n));
+        break;
+    case query::next_prime:
+        out += ' ';
+        append_number(out, CNTCL::next_prime(n));
+        break;
+    }
+    out += '\n';
+}
+
+bool is_space(char c) { return c == ' ' || c == '\n' || c == '\r' || c == '\t'; }
+
+// Answers every record of a block; text blocks end on a record boundary
+void run_block(query q, std::string_view block, bool binary, std::string& out) {
+    out.clear();
+    if (binary) {
+        for (size_t i = 0; i + 8 <= block.size(); i += 8) {
+            answer(q, CNTCL::detail::load_le(reinterpret_cast<const unsigned char*>(block.data() + i), 8), out);
+        }
+        return;
+    }
+
+    const char* p = block.data();
+    const char* const end = p + block.size();
+    while (p < end) {
+        if (is_space(*p)) {
+            p++;
+            continue;
+        }
+        const char* token_end = p;
+        while (token_end < end && !is_space(*token_end)) token_end++;
+        uint64_t n = 0;
+        const auto [ptr, ec] = std::from_chars(p, token_end, n);
+        if (ec == std::errc() && ptr == token_end) {
+            answer(q, n, out);
+        } else {
+            out.append(p, token_end);
+            out += ": invalid\n";
+        }
+        p = token_end;
+    }
+}
+
+// Splits the input into blocks of whole records, from a memory-mapped file
+// or by reading a stream
+class block_reader {
+public:
+    block_reader(std::FILE* file, bool binary) : file_(file), binary_(binary) {}
+
+    block_reader(const char* data, size_t size, bool binary) : data_(data), size_(size), binary_(binary) {}
+
+    // The next block, in storage when streamed; false at the end of input
+    bool next(std::string& storage, std::string_view& block) {
+        if (file_ == nullptr) {
+            if (pos_ >= size_) return false;
+            const size_t length = record_end(std::string_view(data_ + pos_, size_ - pos_), true);
+            block = std::string_view(data_ + pos_, length);
+            pos_ += length;
+            return true;
+        }
+
+        storage.swap(carry_);
+        carry_.clear();
+        const size_t used = storage.size();
+        storage.resize(used + BLOCK_BYTES);
+        storage.resize(used + std::fread(storage.data() + used, 1, BLOCK_BYTES, file_));
+        if (storage.empty()) return false;
+        const bool at_end = storage.size() < used + BLOCK_BYTES;
+        const size_t length = at_end ? storage.size() : record_end(storage, false);
+        carry_.assign(storage, length, std::string::npos);
+        storage.resize(length);
+        block = storage;
+        return true;
+    }
+
+private:
+    std::FILE* file_ = nullptr;
+    const char* data_ = nullptr;
+    size_t size_ = 0, pos_ = 0;
+    bool binary_;
+    std::string carry_;
+
+    // Length of the first block of whole records in rest: about BLOCK_BYTES,
+    // extended to the next whitespace when mapped, cut back to the last one
+    // when streamed (a whole stream buffer without whitespace is taken as is)
+    size_t record_end(std::string_view rest, bool mapped) const {
+        if (rest.size() <= BLOCK_BYTES && mapped) return rest.size();
+        const size_t cut = std::min(rest.size(), BLOCK_BYTES);
+        if (binary_) return cut - cut % 8;
+        if (mapped) {
+            const auto space = std::find_if(rest.begin() + cut, rest.end(), is_space);
+            return space == rest.end() ? rest.size() : size_t(space - rest.begin()) + 1;
+        }
+        for (size_t i = cut; i > 0; i--) {
+            if (is_space(rest[i - 1])) return i;
+        }
+        return cut;
+    }
+};
+
+int usage() {
+    std::fputs("usage: cntcl <isprime|factor|phi|next_prime> [--binary] [--threads N] [file]\n", stderr);
+    return 2;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) return usage();
+    query q;
+    const std::string_view command = argv[1];
+    if (command == "isprime") q = query::isprime;
+    else if (command == "factor") q = query::factor;
+    else if (command == "phi") q = query::phi;
+    else if (command == "next_prime") q = query::next_prime;
+    else return usage();
+
+    bool binary = false;
+    uint32_t threads = std::max(1u, std::thread::hardware_concurrency());
+    const char* path = nullptr;
+    for (int i = 2; i < argc; i++) {
+        const std::string_view arg = argv[i];
+        if (arg == "--binary") {
+            binary = true;
+        } else if (arg == "--threads" && i + 1 < argc) {
+            const std::string_view value = argv[++i];
+            if (std::from_chars(value.data(), value.data() + value.size(), threads).ec != std::errc() || threads == 0) return usage();
+        } else if (path == nullptr && !arg.starts_with("--")) {
+            path = argv[i];
+        } else {
+            return usage();
+        }
+    }
+
+    // Map a regular file; stream stdin, pipes and anything mmap refuses
+    std::FILE* file = stdin;
+    const char* mapped = nullptr;
+    size_t mapped_size = 0;
+    if (path != nullptr) {
+#if HAS_POSIX_MMAP
+        const int fd = ::open(path, O_RDONLY);
+        struct stat info;
+        if (fd >= 0 && ::fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0) {
+            void* p = ::mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p != MAP_FAILED) {
+                ::madvise(p, static_cast<size_t>(info.st_size), MADV_SEQUENTIAL);
+                mapped = static_cast<const char*>(p);
+                mapped_size = static_cast<size_t>(info.st_size);
+            }
+        }
+        if (fd >= 0) ::close(fd);
+#endif
+        if (mapped == nullptr && (file = std::fopen(path, "rb")) == nullptr) {
+            std::fprintf(stderr, "cntcl: cannot open %s: %s\n", path, std::strerror(errno));
+            return 1;
+        }
+    }
+    block_reader reader = mapped != nullptr ? block_reader(mapped, mapped_size, binary) : block_reader(file, binary);
+
+    // One block per thread per round; outputs are written in input order
+    std::vector<std::string> storage(threads), outputs(threads);
+    std::vector<std::string_view> blocks(threads);
+    static char out_buffer[1 << 20];
+    std::setvbuf(stdout, out_buffer, _IOFBF, sizeof(out_buffer));
+    for (bool more = true; more;) {
+        size_t count = 0;
+        while (count < threads && (more = reader.next(storage[count], blocks[count]))) count++;
+        if (count == 0) break;
+
+        std::vector<std::thread> workers;
+        for (size_t i = 1; i < count; i++) workers.emplace_back(run_block, q, blocks[i], binary, std::ref(outputs[i]));
+        run_block(q, blocks[0], binary, outputs[0]);
+        for (auto& worker : workers) worker.join();
+
+        for (size_t i = 0; i < count; i++) {
+            if (std::fwrite(outputs[i].data(), 1, outputs[i].size(), stdout) != outputs[i].size()) {
+                std::fputs("cntcl: write error\n", stderr);
+                return 1;
+            }
+        }
+    }
+    if (std::fflush(stdout) != 0) return 1;
+    if (file != stdin && file != nullptr && mapped == nullptr) std::fclose(file);
+    return 0;
+}
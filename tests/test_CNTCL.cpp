@@ -5,6 +5,13 @@
 #include <chrono>
 #include <vector>
 #include <future>
+#include <string>
+#include <string_view>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include <memory_resource>
+#include <filesystem>
 
 // Helper function for timing
 template<typename F, typename... Args>
@@ -44,9 +51,11 @@ void test_runtime_functions() {
     std::cout << "Testing runtime functions...\n";
     
     // Test prime factorization
-    auto factors = CNTCL::prime_factors(840ULL);  // Use ULL suffix to ensure uint64_t type
+    auto factors = CNTCL::prime_factors(uint64_t{840});  // Brace-init to ensure uint64_t type on every platform
     std::vector<uint64_t> expected_factors = {2, 2, 2, 3, 5, 7};
     assert(factors == expected_factors);
+    assert(CNTCL::euler_phi(uint64_t{840}) == 192 && CNTCL::euler_phi(uint64_t{1}) == 1);
+    assert(CNTCL::euler_phi(uint64_t(1000000007) * 998244353) == uint64_t(1000000006) * 998244352);
     
     // Test SIMD sieve
     auto primes = CNTCL::simd_sieve(30);
@@ -95,17 +104,24 @@ void test_coroutines() {
 void test_thread_local_cache() {
     std::cout << "Testing thread-local cache...\n";
     
+    // 1000 primes near 10^10: enough trial division that a hit must win
+    // (is_prime rejects 1000003 with a few vector multiplies)
+    std::vector<uint64_t> queries;
+    for (uint64_t n = 10000000001ULL; queries.size() < 1000; n += 2) {
+        if (CNTCL::is_probable_prime(n)) queries.push_back(n);
+    }
+    
     // First call - uncached
-    auto time_uncached = measure_time([](){ 
-        for (int i = 0; i < 1000; i++) {
-            CNTCL::PrimeChecker::is_prime_cached(1000003);
+    auto time_uncached = measure_time([&](){ 
+        for (uint64_t n : queries) {
+            CNTCL::PrimeChecker::is_prime_cached(n);
         }
     });
     
     // Second call - should be faster due to caching
-    auto time_cached = measure_time([](){ 
-        for (int i = 0; i < 1000; i++) {
-            CNTCL::PrimeChecker::is_prime_cached(1000003);
+    auto time_cached = measure_time([&](){ 
+        for (uint64_t n : queries) {
+            CNTCL::PrimeChecker::is_prime_cached(n);
         }
     });
     
@@ -153,6 +169,1338 @@ void test_concurrency() {
     std::cout << "Concurrency test passed!\n";
 }
 
+// Test partition numbers
+void test_partitions() {
+    std::cout << "Testing partition numbers...\n";
+    
+    // Compile-time table
+    static_assert(CNTCL::partition_array<10>()[10] == 42, "Partition table test failed");
+    static_assert(CNTCL::partition_array<100>()[100] == 190569292, "Partition table test failed");
+    
+    // Exact 128-bit table: p(1000) = 24061467864032622473692149727991
+    auto exact = CNTCL::partition_table(1000);
+    unsigned __int128 expected = 0;
+    for (char c : std::string("24061467864032622473692149727991")) {
+        expected = expected * 10 + (c - '0');
+    }
+    assert(exact[200] == 3972999029388ULL);
+    assert(exact[1000] == expected);
+    
+    // Pentagonal recurrence mod m agrees with NTT series inversion
+    const uint32_t P = 998244353;
+    auto by_recurrence = CNTCL::partition_table_mod(5000, P);
+    auto by_ntt = CNTCL::partition_numbers_ntt<P>(5000);
+    for (size_t i = 0; i <= 5000; i++) {
+        assert(by_recurrence[i] == by_ntt[i]);
+    }
+    assert(by_recurrence[1000] == static_cast<uint64_t>(expected % P));
+    
+    // Trial division for the root stays in 64 bits for moduli near 2^32
+    static_assert(CNTCL::primitive_root(998244353) == 3, "Primitive root test failed");
+    constexpr uint32_t q = 4294967291u, g = CNTCL::primitive_root(q);
+    for (uint64_t f : {2ULL, 5ULL, 19ULL, 22605091ULL}) assert(CNTCL::modpow<uint64_t>(g, (q - 1) / f, q) != 1);
+    
+    std::cout << "All partition tests passed!\n";
+}
+
+// Test Stirling, Bell and Catalan numbers
+void test_combinatorial_tables() {
+    std::cout << "Testing Stirling, Bell and Catalan numbers...\n";
+    
+    // Row generators reuse one buffer
+    auto s2 = CNTCL::stirling2_rows(11);
+    std::span<const uint64_t> row;
+    while (!s2.done() && row.size() < 11) row = s2.next();
+    std::vector<uint64_t> expected_s2 = {0, 1, 511, 9330, 34105, 42525, 22827, 5880, 750, 45, 1};
+    assert(std::vector<uint64_t>(row.begin(), row.end()) == expected_s2);
+    
+    auto s1 = CNTCL::stirling1_rows(6);
+    for (int i = 0; i < 6; i++) row = s1.next();
+    std::vector<uint64_t> expected_s1 = {0, 24, 50, 35, 10, 1};
+    assert(std::vector<uint64_t>(row.begin(), row.end()) == expected_s1);
+    
+    std::vector<uint64_t> expected_bell = {1, 1, 2, 5, 15, 52, 203, 877, 4140};
+    assert(CNTCL::bell_numbers(8) == expected_bell);
+    assert(CNTCL::bell_numbers_mod(8, 100) == std::vector<uint64_t>({1, 1, 2, 5, 15, 52, 3, 77, 40}));
+    
+    std::vector<uint64_t> expected_catalan = {1, 1, 2, 5, 14, 42, 132, 429, 1430, 4862};
+    assert(CNTCL::catalan_numbers(9) == expected_catalan);
+    auto catalan = CNTCL::catalan_numbers(35);
+    assert(catalan[35] == 3116285494907301262ULL);
+    auto catalan_prime = CNTCL::catalan_numbers_mod(35, 1000000007);
+    auto catalan_composite = CNTCL::catalan_numbers_mod(35, 1000000);
+    for (size_t i = 0; i <= 35; i++) {
+        assert(catalan_prime[i] == catalan[i] % 1000000007);
+        assert(catalan_composite[i] == catalan[i] % 1000000);
+    }
+    // Factorials up to (2n)! stay invertible when m = 2n + 1
+    assert(CNTCL::catalan_numbers_mod(3, 7) == (std::vector<uint64_t>{1, 1, 2, 5}));
+    assert(CNTCL::catalan_numbers_mod(5, 11) == (std::vector<uint64_t>{1, 1, 2, 5, 3, 9}));
+    assert(CNTCL::catalan_numbers_mod(35, 71)[35] == catalan[35] % 71);
+    
+    // Everything is 0 mod 1, including the seed of each row generator
+    assert(CNTCL::bell_numbers_mod(5, 1) == std::vector<uint64_t>(6, 0));
+    assert(CNTCL::catalan_numbers_mod(5, 1) == std::vector<uint64_t>(6, 0));
+    assert(CNTCL::partition_table_mod(5, 1) == std::vector<uint64_t>(6, 0));
+    auto all_zero = [](CNTCL::row_generator<uint64_t> rows) {
+        for (int i = 0; i < 6; i++) {
+            for (uint64_t v : rows.next()) {
+                if (v != 0) return false;
+            }
+        }
+        return true;
+    };
+    assert(all_zero(CNTCL::stirling1_rows_mod(6, 1)));
+    assert(all_zero(CNTCL::stirling2_rows_mod(6, 1)));
+    assert(all_zero(CNTCL::bell_triangle_rows_mod(6, 1)));
+    
+    // NTT whole-row computation agrees with the generators
+    const uint32_t P = 998244353;
+    auto s1_mod = CNTCL::stirling1_rows_mod(301, P);
+    auto s2_mod = CNTCL::stirling2_rows_mod(301, P);
+    std::span<const uint64_t> row1, row2;
+    for (int i = 0; i <= 300; i++) {
+        row1 = s1_mod.next();
+        row2 = s2_mod.next();
+    }
+    auto ntt1 = CNTCL::stirling1_row_ntt<P>(300);
+    auto ntt2 = CNTCL::stirling2_row_ntt<P>(300);
+    for (size_t k = 0; k <= 300; k++) {
+        assert(ntt1[k] == row1[k]);
+        assert(ntt2[k] == row2[k]);
+    }
+    
+    std::cout << "All combinatorial table tests passed!\n";
+}
+
+// Test sublinear summatory functions
+void test_summatory_functions() {
+    std::cout << "Testing sublinear summatory functions...\n";
+    
+    // Cross-check against a sieve of phi and mu up to 10^6
+    const uint64_t N = 1000000;
+    std::vector<uint64_t> phi(N + 1);
+    std::vector<int> mu(N + 1, 1);
+    for (uint64_t i = 0; i <= N; i++) phi[i] = i;
+    std::vector<bool> composite(N + 1, false);
+    for (uint64_t p = 2; p <= N; p++) {
+        if (composite[p]) continue;
+        for (uint64_t m = p; m <= N; m += p) {
+            if (m > p) composite[m] = true;
+            phi[m] -= phi[m] / p;
+            mu[m] = -mu[m];
+        }
+        for (uint64_t m = p * p; m <= N; m += p * p) mu[m] = 0;
+    }
+    
+    uint64_t count = 0, sum = 0, phi_sum = 0;
+    int64_t mertens = 0;
+    for (uint64_t n = 1; n <= N; n++) {
+        if (n > 1 && !composite[n]) {
+            count++;
+            sum += n;
+        }
+        phi_sum += phi[n];
+        mertens += mu[n];
+        if (n == 1 || n == 999 || n == 65536 || n == N) {
+            assert(CNTCL::prime_count(n) == count);
+            assert(CNTCL::prime_sum(n) == sum);
+            assert(CNTCL::totient_summatory(n) == phi_sum);
+            assert(CNTCL::mertens(n) == mertens);
+        }
+    }
+    
+    // Larger known values, single- and multi-threaded
+    assert(CNTCL::prime_count(10000000000ULL, 1) == 455052511);
+    assert(CNTCL::prime_count(10000000000ULL, 4) == 455052511);
+    assert(CNTCL::prime_sum(10000000000ULL, 1) == 2220822432581729238ULL);
+    assert(CNTCL::prime_sum(10000000000ULL, 3) == 2220822432581729238ULL);
+    assert(CNTCL::mertens(1000000000ULL, 1) == -222);
+    assert(CNTCL::mertens(1000000000ULL, 4) == -222);
+    
+    std::cout << "All summatory function tests passed!\n";
+}
+
+// Test Jacobi and Kronecker symbols
+void test_jacobi_symbols() {
+    std::cout << "Testing Jacobi and Kronecker symbols...\n";
+    
+    static_assert(CNTCL::jacobi<uint64_t>(1001, 9907) == -1, "Jacobi test failed");
+    static_assert(CNTCL::jacobi<uint64_t>(19, 45) == 1, "Jacobi test failed");
+    static_assert(CNTCL::jacobi<uint64_t>(30, 45) == 0, "Jacobi test failed");
+    static_assert(CNTCL::kronecker(3, 8) == -1, "Kronecker test failed");
+    static_assert(CNTCL::kronecker(-3, -7) == -1, "Kronecker test failed");
+    static_assert(CNTCL::kronecker(2, 8) == 0, "Kronecker test failed");
+    
+    // Textbook algorithm with % as the reference
+    auto reference = [](uint64_t a, uint64_t n) {
+        int t = 1;
+        a %= n;
+        while (a != 0) {
+            while (a % 2 == 0) {
+                a /= 2;
+                if (n % 8 == 3 || n % 8 == 5) t = -t;
+            }
+            std::swap(a, n);
+            if (a % 4 == 3 && n % 4 == 3) t = -t;
+            a %= n;
+        }
+        return n == 1 ? t : 0;
+    };
+    
+    std::vector<uint64_t> values;
+    for (uint64_t a = 0; a < 400; a++) values.push_back(a * 0x9E3779B97F4A7C15ULL >> (a % 64));
+    std::vector<int8_t> batch(values.size());
+    for (uint64_t n = 1; n < 300; n += 2) {
+        CNTCL::jacobi_batch(values, n, batch);
+        for (size_t i = 0; i < values.size(); i++) {
+            assert(CNTCL::jacobi<uint64_t>(values[i], n) == reference(values[i], n));
+            assert(batch[i] == reference(values[i], n));
+        }
+    }
+    
+    // Euler's criterion on a 64-bit prime
+    const uint64_t p = 18446744073709551557ULL;
+    for (uint64_t a = 2; a < 50; a++) {
+        uint64_t r = 1, b = a;
+        for (uint64_t e = (p - 1) / 2; e > 0; e >>= 1) {
+            if (e & 1) r = CNTCL::mulmod(r, b, p);
+            b = CNTCL::mulmod(b, b, p);
+        }
+        assert(CNTCL::jacobi<uint64_t>(a, p) == (r == 1 ? 1 : -1));
+    }
+    
+    // 128-bit: n = 2^127 - 1 is prime and 7 (mod 8)
+    const unsigned __int128 m127 = (static_cast<unsigned __int128>(1) << 127) - 1;
+    assert(CNTCL::jacobi<unsigned __int128>(2, m127) == 1);
+    assert(CNTCL::jacobi<unsigned __int128>(3, m127) == -1);
+    
+    std::cout << "All Jacobi symbol tests passed!\n";
+}
+
+// Test integer roots and perfect powers
+void test_integer_roots() {
+    std::cout << "Testing integer roots and perfect powers...\n";
+    
+    static_assert(CNTCL::isqrt(99) == 9 && CNTCL::isqrt(100) == 10, "isqrt test failed");
+    static_assert(CNTCL::isqrt(UINT64_MAX) == 4294967295ULL, "isqrt test failed");
+    static_assert(CNTCL::icbrt(UINT64_MAX) == 2642245, "icbrt test failed");
+    static_assert(CNTCL::iroot(UINT64_MAX, 5) == 7131, "iroot test failed");
+    static_assert(CNTCL::is_perfect_power(1ULL << 62), "Perfect power test failed");
+    static_assert(!CNTCL::is_perfect_power(1000001), "Perfect power test failed");
+    
+    // Runtime paths at the edges of each exponent
+    for (unsigned k = 2; k <= 40; k++) {
+        for (uint64_t r = 2; CNTCL::detail::pow_leq(r, k, UINT64_MAX); r += (r >> 3) + 1) {
+            uint64_t n = 1;
+            for (unsigned i = 0; i < k; i++) n *= r;
+            assert(CNTCL::iroot(n, k) == r);
+            assert(CNTCL::iroot(n - 1, k) == r - 1);
+            auto pp = CNTCL::perfect_power(n);
+            assert(pp.has_value() && pp->second % k == 0);
+            uint64_t check = 1;
+            for (unsigned i = 0; i < pp->second; i++) check *= pp->first;
+            assert(check == n);
+        }
+    }
+    assert(CNTCL::isqrt(UINT64_MAX) == 4294967295ULL);
+    assert(CNTCL::icbrt(UINT64_MAX) == 2642245);
+    assert(CNTCL::perfect_power(1ULL << 60) == std::make_pair(uint64_t(2), 60u));
+    assert(CNTCL::perfect_power(6561) == std::make_pair(uint64_t(3), 8u));
+    
+    // Count perfect powers up to 10^6 against brute force
+    std::vector<bool> is_power(1000001, false);
+    for (uint64_t b = 2; b * b <= 1000000; b++) {
+        for (uint64_t n = b * b; n <= 1000000; n *= b) is_power[n] = true;
+    }
+    for (uint64_t n = 0; n <= 1000000; n++) {
+        assert(CNTCL::is_perfect_power(n) == is_power[n]);
+    }
+    
+    // Trial-division bounds come from isqrt instead of squaring the counter
+    assert(CNTCL::is_prime(4294967291ULL));
+    assert(CNTCL::simd_sieve(65537).back() == 65537);
+    
+    // The bitmap size is computed in 64 bits, so the top limit does not wrap
+    const auto all_primes = CNTCL::simd_sieve(UINT32_MAX);
+    assert(all_primes.size() == 203280221 && all_primes.back() == 4294967291u);
+    
+    std::cout << "All integer root tests passed!\n";
+}
+
+// Test fixed-width multiword integers
+void test_multiword_integers() {
+    std::cout << "Testing fixed-width multiword integers...\n";
+    using u128 = unsigned __int128;
+    using u256 = CNTCL::uint_t<256>;
+    using u512 = CNTCL::uint_t<512>;
+    
+    // Compile-time arithmetic
+    constexpr u256 big = (u256(1) << 120) + 12345;
+    static_assert((big * big) / big == big, "uint_t multiplication/division test failed");
+    static_assert(big % 1000 == (u256(1) << 120) % 1000 + 345, "uint_t remainder test failed");
+    static_assert(CNTCL::gcd(u256(1) << 150, u256(3) << 100) == u256(1) << 100, "uint_t gcd test failed");
+    static_assert(CNTCL::modpow(u256(4), u256(13), u256(497)) == 445, "uint_t modpow test failed");
+    
+    // uint_t<128> matches unsigned __int128 bit for bit
+    uint64_t state = 88172645463325252ULL;
+    auto next_random = [&state]() {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return state;
+    };
+    for (int i = 0; i < 2000; i++) {
+        u128 a = (u128(next_random()) << 64) | next_random();
+        u128 b = (u128(next_random()) << (i % 64)) | next_random();
+        CNTCL::uint_t<128> wa = a, wb = b;
+        assert(static_cast<u128>(wa + wb) == a + b);
+        assert(static_cast<u128>(wa - wb) == a - b);
+        assert(static_cast<u128>(wa * wb) == a * b);
+        assert(static_cast<u128>(wa / wb) == a / b);
+        assert(static_cast<u128>(wa % wb) == a % b);
+        assert(static_cast<u128>(wa >> (i % 128)) == a >> (i % 128));
+        assert(static_cast<u128>(wa << (i % 128)) == a << (i % 128));
+        assert((wa < wb) == (a < b));
+    }
+    
+    // Division identity and Karatsuba against the schoolbook product
+    for (int i = 0; i < 500; i++) {
+        u512 a, b;
+        for (auto& limb : a.limbs) limb = next_random();
+        for (size_t j = 0; j <= size_t(i % 8); j++) b.limbs[j] = next_random();
+        auto [q, r] = divmod(a, b);
+        assert(r < b && q * b + r == a);
+        
+        CNTCL::uint_t<1024> a1024(a), b1024(b);
+        assert(CNTCL::mul_wide(a, b) == a1024 * b1024);
+        CNTCL::uint_t<2048> wide = CNTCL::mul_wide(a1024, b1024 << 300);
+        assert(wide == CNTCL::uint_t<2048>(a1024) * (CNTCL::uint_t<2048>(b1024) << 300));
+    }
+    assert(CNTCL::to_string(u256(1) << 128) == "340282366920938463463374607431768211456");
+    assert(CNTCL::to_string((u128(1) << 127) - 1) == "170141183460469231731687303715884105727");
+    
+    // Miller-Rabin and Baillie-PSW
+    assert(!CNTCL::is_probable_prime(3215031751ULL));          // strong pseudoprime to 2, 3, 5, 7
+    assert(CNTCL::is_probable_prime(18446744073709551557ULL)); // largest 64-bit prime
+    for (uint64_t n = 0; n < 100000; n++) {
+        assert(CNTCL::is_probable_prime(n) == CNTCL::is_prime(n));
+    }
+    const u256 p25519 = (u256(1) << 255) - 19;
+    const u128 m127 = (u128(1) << 127) - 1;
+    assert(CNTCL::is_probable_prime(p25519));
+    assert(CNTCL::is_probable_prime(m127));
+    assert(!CNTCL::is_probable_prime(u256(m127) * 3));
+    assert(CNTCL::modpow(u256(2), p25519 - 1, p25519) == 1);
+    
+    // Pollard's rho through prime_factors, built-in and multiword
+    auto f64 = CNTCL::prime_factors(uint64_t(1000000007) * 998244353);
+    assert(f64 == std::vector<uint64_t>({998244353, 1000000007}));
+    const u256 composite = u256(1000000007) * 998244353 * 1099511627791ULL * m127;
+    auto f256 = CNTCL::prime_factors(composite);
+    assert(f256.size() == 4 && f256[0] == 998244353 && f256[1] == 1000000007);
+    assert(f256[2] == 1099511627791ULL && f256[3] == u256(m127));
+    
+    std::cout << "All multiword integer tests passed!\n";
+}
+
+// Test arbitrary-precision integers
+void test_big_integers() {
+    std::cout << "Testing arbitrary-precision integers...\n";
+    using big = CNTCL::big_uint<>;
+    
+    uint64_t state = 0x2545F4914F6CDD1DULL;
+    auto next_random = [&state]() {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return state;
+    };
+    auto random_limbs = [&](size_t n) {
+        std::vector<uint64_t> limbs(n);
+        for (auto& limb : limbs) limb = next_random();
+        return limbs;
+    };
+    
+    // Every rung of the multiplication ladder agrees with schoolbook
+    for (auto [na, nb] : {std::pair<size_t, size_t>{40, 33}, {97, 64}, {200, 180}, {301, 170}, {700, 650}, {2000, 1600}}) {
+        auto a = random_limbs(na), b = random_limbs(nb);
+        std::vector<uint64_t> expected(na + nb), actual(na + nb);
+        CNTCL::detail::mul_limbs_schoolbook(expected.data(), a.data(), na, b.data(), nb);
+        CNTCL::detail::mul_karatsuba(actual.data(), a.data(), na, b.data(), nb);
+        assert(actual == expected);
+        CNTCL::detail::mul_toom3(actual.data(), a.data(), na, b.data(), nb);
+        assert(actual == expected);
+        assert(CNTCL::detail::mul_ntt(actual.data(), a.data(), na, b.data(), nb));
+        assert(actual == expected);
+        CNTCL::detail::mul_limbs(actual.data(), a.data(), na, b.data(), nb);
+        assert(actual == expected);
+    }
+    
+    // Division identity and decimal round trip
+    for (int i = 0; i < 50; i++) {
+        big a, b;
+        for (uint64_t limb : random_limbs(1 + i * 3)) a = (a << 64) + big(limb);
+        for (uint64_t limb : random_limbs(1 + i)) b = (b << 64) + big(limb);
+        auto [q, r] = divmod(a, b);
+        assert(r < b && q * b + r == a);
+        assert(big(to_string(a)) == a);
+    }
+    
+    // Factorial, primorial and exact partition numbers
+    assert(to_string(CNTCL::factorial(100)) ==
+           "93326215443944152681699238856266700490715968264381621468592963895217599993229915608941463976156518286253697920827223758251185210916864000000000000000000000000");
+    assert(to_string(CNTCL::factorial(1000)).size() == 2568);
+    assert(to_string(CNTCL::primorial(100)) == "2305567963945518424753102147331756070");
+    auto partitions = CNTCL::partition_table<big>(2000);
+    assert(to_string(partitions[2000]) == "4720819175619413888601432406799959512200344166");
+    
+    // CRT reconstruction of 100! from its residues
+    const big f100 = CNTCL::factorial(100);
+    std::vector<uint64_t> moduli, residues;
+    for (uint64_t m = 1000000007; moduli.size() < 20; m += 2) {
+        if (CNTCL::is_probable_prime(m)) {
+            moduli.push_back(m);
+            residues.push_back(divmod(f100, m).second);
+        }
+    }
+    assert(CNTCL::crt(residues, moduli) == f100);
+    
+    // Concurrent products of several lengths share the twiddle tables
+    std::vector<std::vector<uint32_t>> inputs, serial;
+    for (size_t len = 64; len <= 65536; len *= 4) {
+        std::vector<uint32_t> v(len);
+        for (size_t i = 0; i < len; i++) v[i] = static_cast<uint32_t>((i * 2654435761u) % 998244353);
+        inputs.push_back(v);
+        serial.push_back(CNTCL::ntt_multiply(v, v));
+    }
+    std::vector<std::future<bool>> products;
+    for (int round = 0; round < 4; round++) {
+        for (size_t i = 0; i < inputs.size(); i++) {
+            products.push_back(std::async(std::launch::async, [&, i] {
+                return CNTCL::ntt_multiply(inputs[i], inputs[i]) == serial[i];
+            }));
+        }
+    }
+    for (auto& product : products) assert(product.get());
+    
+    std::cout << "All arbitrary-precision integer tests passed!\n";
+}
+
+// Test polynomials over Z/pZ
+void test_polynomials() {
+    std::cout << "Testing polynomials over Z/pZ...\n";
+    constexpr uint32_t P = 998244353;
+    using poly = CNTCL::poly_mod<P>;
+    
+    uint64_t state = 0x853C49E6748FEA9BULL;
+    auto random_poly = [&state](size_t n) {
+        std::vector<uint32_t> c(n);
+        for (auto& x : c) {
+            state ^= state << 13;
+            state ^= state >> 7;
+            state ^= state << 17;
+            x = static_cast<uint32_t>(state % P);
+        }
+        if (n > 0 && c.back() == 0) c.back() = 1;
+        return poly(std::move(c));
+    };
+    
+    // Arithmetic and division on both the schoolbook and Newton paths
+    const poly f{1, 2, 3}, g{4, 5};
+    assert((f * g == poly{4, 13, 22, 15}));
+    assert((f - f).is_zero() && (f + g == poly{5, 7, 3}));
+    for (auto [na, nb] : {std::pair<size_t, size_t>{50, 10}, {3000, 1200}, {5000, 40}, {40, 60}}) {
+        const poly a = random_poly(na), b = random_poly(nb);
+        const auto [q, r] = divmod(a, b);
+        assert(q * b + r == a);
+        assert(r.degree() < b.degree());
+    }
+    
+    // Power series: inverse, log and exp
+    const poly h = random_poly(2000);
+    assert((h * h.inverse(1500)).truncated(1500) == poly{1});
+    const poly h1 = h - poly{h[0]} + poly{1};
+    assert(h1.log(1000).exp(1000) == h1.truncated(1000));
+    const poly e = poly{0, 1}.exp(10);  // e^x = sum x^k / k!
+    for (uint32_t k = 0, factorial = 1; k < 10; k++, factorial *= std::max(k, 1u)) {
+        assert(uint64_t(e[k]) * factorial % P == 1);
+    }
+    
+    // Multipoint evaluation and interpolation round trip
+    const poly m = random_poly(3000);
+    std::vector<uint32_t> points(3000);
+    for (uint32_t i = 0; i < points.size(); i++) points[i] = i * 7919 + 3;
+    const auto values = m.evaluate(points);
+    for (size_t i = 0; i < points.size(); i += 97) assert(values[i] == m(points[i]));
+    assert(poly::interpolate(points, values) == m);
+    assert(m.evaluate(points, 1) == values);
+    const poly low = random_poly(200);
+    const auto low_values = low.evaluate(points);
+    for (size_t i = 0; i < points.size(); i += 101) assert(low_values[i] == low(points[i]));
+    
+    // Composition against Horner's rule in power series
+    const poly a = random_poly(60), b = random_poly(70);
+    poly expected;
+    for (size_t i = a.size(); i-- > 0;) expected = (expected * b).truncated(50) + poly{a[i]};
+    assert(compose(a, b, 50) == expected);
+    
+    std::cout << "All polynomial tests passed!\n";
+}
+
+// Test polynomial factorization and roots mod p
+void test_polynomial_factorization() {
+    std::cout << "Testing polynomial factorization mod p...\n";
+    
+    uint64_t state = 0xDA942042E4DD58B5ULL;
+    auto next_random = [&state]() {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return state;
+    };
+    auto evaluate = [](const std::vector<uint64_t>& f, uint64_t x, uint64_t m) {
+        uint64_t r = 0;
+        for (size_t i = f.size(); i-- > 0;) r = (CNTCL::mulmod(r, x, m) + f[i] % m) % m;
+        return r;
+    };
+    
+    // Roots against brute force, including repeated roots and p = 2
+    for (uint64_t p : {2ULL, 3ULL, 101ULL, 65537ULL}) {
+        for (int trial = 0; trial < 20; trial++) {
+            std::vector<uint64_t> f(2 + next_random() % 12);
+            for (auto& c : f) c = next_random() % p;
+            std::vector<uint64_t> expected;
+            const bool vanishes = std::ranges::all_of(f, [p](uint64_t c) { return c % p == 0; });
+            for (uint64_t x = 0; x < std::min<uint64_t>(p, 70000) && !vanishes; x++) {
+                if (evaluate(f, x, p) == 0) expected.push_back(x);
+            }
+            assert(CNTCL::roots_mod_p(f, p) == expected);
+        }
+    }
+    
+    // Factors multiply back to the monic polynomial, across both
+    // multiplication paths (p < 2^32 and p > 2^32)
+    for (uint64_t p : {2ULL, 7ULL, 998244353ULL, 1000000000039ULL}) {
+        std::vector<uint64_t> f{1};
+        for (int i = 0; i < 6; i++) {
+            std::vector<uint64_t> g(2 + next_random() % 5);
+            for (auto& c : g) c = next_random() % p;
+            g.back() = 1;
+            f = CNTCL::detail::poly_multiply_mod(f, g, p);
+            if (i % 2 == 0) f = CNTCL::detail::poly_multiply_mod(f, g, p);
+        }
+        const auto factors = CNTCL::factor_mod_p(f, p);
+        std::vector<uint64_t> product{1};
+        for (const auto& g : factors) {
+            assert(g.back() == 1);
+            if (g.size() <= 4) assert(g.size() == 2 || CNTCL::roots_mod_p(g, p).empty());
+            product = CNTCL::detail::poly_multiply_mod(product, g, p);
+        }
+        assert(product == f);
+    }
+    
+    // x^8 - x over F_2 is the product of all irreducibles of degree 1 and 3
+    std::vector<uint64_t> frobenius(9, 0);
+    frobenius[1] = frobenius[8] = 1;
+    assert(CNTCL::factor_mod_p(frobenius, 2) ==
+           (std::vector<std::vector<uint64_t>>{{0, 1}, {1, 1}, {1, 1, 0, 1}, {1, 0, 1, 1}}));
+    
+    // Large prime: 100 prescribed roots of a product of linear factors
+    constexpr uint64_t P = 18446744073709551557ULL;  // 2^64 - 59
+    std::vector<uint64_t> linear{1};
+    std::vector<uint64_t> expected_roots;
+    for (uint64_t i = 1; i <= 100; i++) {
+        expected_roots.push_back(i * i * 1234567);
+        linear = CNTCL::detail::poly_multiply_mod(linear, {P - expected_roots.back(), 1}, P);
+    }
+    assert(CNTCL::roots_mod_p(linear, P) == expected_roots);
+    
+    // Hensel lifting and composite moduli against brute force
+    const std::vector<uint64_t> congruences[] = {{1, 0, 1}, {0, 0, 1}, {6, 11, 6, 1}, {2, 0, 0, 1}, {3, 3}, {30, 0, 12}};
+    for (const auto& f : congruences) {
+        for (uint64_t n : {64ULL, 81ULL, 125ULL * 13, 2ULL * 3 * 5 * 7 * 11, 4096ULL, 1ULL}) {
+            std::vector<uint64_t> expected;
+            for (uint64_t x = 0; x < n; x++) {
+                if (evaluate(f, x, n) == 0) expected.push_back(x);
+            }
+            assert(CNTCL::solve_poly_congruence(f, n) == expected);
+        }
+    }
+    assert(CNTCL::roots_mod_prime_power(std::vector<uint64_t>{1, 0, 1}, 5, 20).size() == 2);
+    
+    // roots_mod_p rejects a polynomial that vanishes mod p instead of listing every residue
+    assert(CNTCL::roots_mod_p(std::vector<uint64_t>{P, 2 * 7}, P).size() == 1);
+    assert(CNTCL::roots_mod_p(std::vector<uint64_t>{0, 0, 0}, P).empty());
+    assert(CNTCL::roots_mod_p(std::vector<uint64_t>{7, 14}, 7).empty());
+    
+    // Lifting starts from every residue when f vanishes mod p
+    assert(CNTCL::roots_mod_prime_power(std::vector<uint64_t>{0, 7}, 7, 1).size() == 7);
+    assert(CNTCL::solve_poly_congruence(std::vector<uint64_t>{3, 3}, 9) == (std::vector<uint64_t>{2, 5, 8}));
+    assert(CNTCL::solve_poly_congruence(std::vector<uint64_t>{0, 2}, 4) == (std::vector<uint64_t>{0, 2}));
+    assert(CNTCL::solve_poly_congruence(std::vector<uint64_t>{2, 2}, 12) == (std::vector<uint64_t>{5, 11}));
+    assert(CNTCL::solve_poly_congruence(std::vector<uint64_t>{0, 0, 0}, 1625).size() == 1625);
+    
+    // CRT steps with a prime power above 2^63 do not overflow
+    assert(CNTCL::solve_poly_congruence(std::vector<uint64_t>{P - 1000, 1}, P) == (std::vector<uint64_t>{1000}));
+    
+    std::cout << "All polynomial factorization tests passed!\n";
+}
+
+// Test smooth-number enumeration and smoothness testing
+void test_smooth_numbers() {
+    std::cout << "Testing smooth numbers...\n";
+    
+    // Enumeration against trial factorization
+    auto largest_factor = [](uint64_t n) { return n == 1 ? 1 : CNTCL::prime_factors(n).back(); };
+    const auto smooth = CNTCL::smooth_numbers(100000, 13);
+    std::vector<uint64_t> expected;
+    for (uint64_t n = 1; n <= 100000; n++) {
+        if (largest_factor(n) <= 13) expected.push_back(n);
+    }
+    assert(smooth == expected);
+    assert(CNTCL::smooth_numbers(1000000, 7).size() == 1273);
+    
+    size_t count = 0;
+    CNTCL::for_each_smooth(uint64_t(1) << 40, 2, [&](uint64_t) { count++; });
+    assert(count == 41);
+    
+    // Batch smooth parts across the tiny-prime, prime-cofactor and
+    // remainder-tree paths, including values near 2^64
+    uint64_t state = 0x94D049BB133111EBULL;
+    std::vector<uint64_t> values{0, 1, 2, 67 * 67, 1000003ULL * 1000033, 18446744073709551557ULL, UINT64_MAX};
+    while (values.size() < 3000) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        values.push_back(state >> (state % 48));
+    }
+    for (uint32_t bound : {10u, 67u, 1000u, 100000u}) {
+        const auto parts = CNTCL::smooth_parts(values, bound);
+        for (size_t i = 0; i < values.size(); i++) {
+            uint64_t part = 1;
+            if (values[i] > 1) {
+                for (uint64_t p : CNTCL::prime_factors(values[i])) {
+                    if (p <= bound) part *= p;
+                }
+            }
+            assert(parts[i] == part);
+        }
+    }
+    const std::vector<uint64_t> candidates{0, 720, 721, 1024, 1000003, 2 * 3 * 5 * 7 * 11 * 13 * 17 * 19 * 23ULL};
+    assert((CNTCL::select_smooth(candidates, 23) == std::vector<uint64_t>{720, 1024, 223092870}));
+    
+    std::cout << "All smooth number tests passed!\n";
+}
+
+// Test the segmented sieve and prime k-tuples
+void test_segmented_sieve() {
+    std::cout << "Testing segmented sieve and prime k-tuples...\n";
+    
+    // Ranges that start, end and straddle segment boundaries agree with simd_sieve
+    const auto reference = CNTCL::simd_sieve(3000000);
+    std::vector<bool> is_prime(3000100, false);
+    for (uint32_t p : reference) is_prime[p] = true;
+    const std::pair<uint64_t, uint64_t> ranges[] = {{0, 100}, {1, 2}, {2, 3}, {3, 4}, {0, 3000000}, {12345, 2999999}, {524288, 1048577}};
+    for (auto [lo, hi] : ranges) {
+        std::vector<uint64_t> primes, expected;
+        CNTCL::for_each_prime(lo, hi, [&](uint64_t p) { primes.push_back(p); });
+        for (uint32_t p : reference) {
+            if (p >= lo && p < hi) expected.push_back(p);
+        }
+        assert(primes == expected);
+        assert(CNTCL::count_primes_segmented(lo, hi, 4) == expected.size());
+        
+        // Tuples against the reference bitmap, streamed and counted
+        for (std::span<const uint32_t> offsets : {std::span<const uint32_t>(CNTCL::twin_primes),
+                                                  std::span<const uint32_t>(CNTCL::prime_quadruplets),
+                                                  std::span<const uint32_t>(CNTCL::prime_sextuplets)}) {
+            std::vector<uint64_t> starts, expected_starts;
+            CNTCL::for_each_prime_tuple(lo, hi, offsets, [&](uint64_t p) { starts.push_back(p); });
+            for (uint64_t p : expected) {
+                bool all = p > 2;
+                for (uint32_t d : offsets) all = all && is_prime[p + d];
+                if (all) expected_starts.push_back(p);
+            }
+            assert(starts == expected_starts);
+            assert(CNTCL::count_prime_tuples(lo, hi, offsets, 3) == starts.size());
+        }
+    }
+    
+    // Known counts and a window far above the base primes
+    assert(CNTCL::count_primes_segmented(0, 100000000) == 5761455);
+    assert(CNTCL::count_prime_tuples(0, 100000000, CNTCL::twin_primes) == 440312);
+    const uint64_t lo = 1000000000000ULL, hi = lo + 200000;
+    uint64_t window = 0;
+    for (uint64_t n = lo + 1; n < hi; n += 2) window += CNTCL::is_probable_prime(n);
+    assert(CNTCL::count_primes_segmented(lo, hi, 2) == window);
+    
+    // A window just below 2^64: base primes up to 2^32 and multiples past 2^64
+    std::vector<uint64_t> top, top_expected;
+    CNTCL::for_each_prime(UINT64_MAX - 3000, UINT64_MAX, [&](uint64_t p) { top.push_back(p); });
+    for (uint64_t n = UINT64_MAX - 3000; n < UINT64_MAX; n++) {
+        if (CNTCL::is_probable_prime(n)) top_expected.push_back(n);
+    }
+    assert(top == top_expected && top.size() == 69);
+    
+    std::cout << "All segmented sieve tests passed!\n";
+}
+
+// Test streaming prime-gap statistics
+void test_prime_gaps() {
+    std::cout << "Testing prime gap statistics...\n";
+    
+    const auto primes = CNTCL::simd_sieve(2000000);
+    for (auto [lo, hi] : {std::pair<uint64_t, uint64_t>{0, 2000000}, {1000, 1900000}, {1327, 1361}, {24, 28}}) {
+        // Reference statistics from the materialized prime list
+        std::vector<uint64_t> in_range;
+        for (uint32_t p : primes) {
+            if (p >= lo && p < hi) in_range.push_back(p);
+        }
+        std::vector<uint64_t> histogram, first;
+        std::vector<std::pair<uint64_t, uint64_t>> maximal;
+        for (size_t i = 1; i < in_range.size(); i++) {
+            const uint64_t g = in_range[i] - in_range[i - 1];
+            if (g >= histogram.size()) {
+                histogram.resize(g + 1);
+                first.resize(g + 1);
+            }
+            if (histogram[g]++ == 0) first[g] = in_range[i - 1];
+            if (maximal.empty() || g > maximal.back().second) maximal.push_back({in_range[i - 1], g});
+        }
+        
+        for (uint32_t threads : {1u, 3u, 8u}) {
+            const auto stats = CNTCL::prime_gap_statistics(lo, hi, threads);
+            assert(stats.prime_count == in_range.size());
+            assert(stats.histogram == histogram);
+            assert(stats.first_occurrence == first);
+            assert(stats.maximal_gaps.size() == maximal.size());
+            for (size_t i = 0; i < maximal.size(); i++) {
+                assert(stats.maximal_gaps[i].start == maximal[i].first && stats.maximal_gaps[i].length == maximal[i].second);
+            }
+        }
+    }
+    
+    // The largest merit below 2 * 10^6 belongs to the maximal gap of 132 after 1357201
+    const auto stats = CNTCL::prime_gap_statistics(0, 2000000);
+    assert(stats.max_merit.start == 1357201 && stats.max_merit.length == 132);
+    assert((CNTCL::prime_gap{1327, 34}.merit() > 4.7));
+    assert(CNTCL::prime_gap_statistics(24, 28).prime_count == 0);
+    
+    std::cout << "All prime gap tests passed!\n";
+}
+
+// Test on-disk prime tables
+void test_prime_tables() {
+    std::cout << "Testing on-disk prime tables...\n";
+    
+    const std::string path = (std::filesystem::temp_directory_path() / "cntcl_test_prime_table.bin").string();
+    const auto primes = CNTCL::simd_sieve(1000000);
+    assert(CNTCL::write_prime_table(path, 0, 1000000));
+    {
+        auto table = CNTCL::prime_table::open(path);
+        assert(table && table->size() == primes.size() && table->lo() == 0 && table->hi() == 1000000);
+        assert((*table)[0] == 2 && (*table)[1] == 3 && (*table)[primes.size() - 1] == 999983);
+        
+        // Iteration, index access and membership against the sieve
+        size_t i = 0;
+        for (uint64_t p : *table) assert(p == primes[i++]);
+        assert(i == primes.size());
+        for (size_t k = 0; k < primes.size(); k += 97) assert((*table)[k] == primes[k]);
+        std::vector<bool> composite(1000000, true);
+        for (uint32_t p : primes) composite[p] = false;
+        for (uint64_t n = 0; n < 1000000; n++) assert(table->is_prime(n) == !composite[n]);
+        for (uint64_t n : {0ULL, 2ULL, 3ULL, 100ULL, 7919ULL, 999983ULL, 999999ULL}) {
+            assert(table->rank(n) == size_t(std::lower_bound(primes.begin(), primes.end(), n) - primes.begin()));
+        }
+        
+        // Slightly over a byte per prime instead of four
+        std::FILE* file = std::fopen(path.c_str(), "rb");
+        std::fseek(file, 0, SEEK_END);
+        const long file_size = std::ftell(file);
+        assert(file_size < long(primes.size() * 1.1));
+        
+        // Checkpoints past the gap stream are rejected; a stream cut short
+        // behind the last checkpoint is read no further than its end
+        std::vector<unsigned char> bytes(file_size);
+        std::fseek(file, 0, SEEK_SET);
+        assert(std::fread(bytes.data(), 1, bytes.size(), file) == bytes.size());
+        std::fclose(file);
+        const uint64_t gap_bytes = CNTCL::detail::load_le(bytes.data() + 56, 8);
+        const uint64_t last = CNTCL::detail::load_le(bytes.data() + 64, 8) + 16 * (CNTCL::detail::load_le(bytes.data() + 72, 8) - 1);
+        auto corrupt = bytes;
+        CNTCL::detail::store_le(corrupt.data() + last + 8, gap_bytes + 1, 8);
+        assert(!CNTCL::prime_table::view(corrupt));
+        auto truncated = bytes;
+        CNTCL::detail::store_le(truncated.data() + 56, CNTCL::detail::load_le(bytes.data() + last + 8, 8), 8);
+        auto cut = CNTCL::prime_table::view(truncated);
+        assert(cut && (*cut)[primes.size() - 1] == CNTCL::detail::load_le(bytes.data() + last, 8));
+        assert(!cut->is_prime(999983) && cut->rank(1000000) == primes.size());
+    }
+    
+    // A window with the 1132 gap after 1693182318746371 takes the escape path
+    const uint64_t lo = 1693182318746000ULL, hi = lo + 2000;
+    assert(CNTCL::write_prime_table(path, lo, hi));
+    auto window = CNTCL::prime_table::open(path);
+    std::vector<uint64_t> expected;
+    CNTCL::for_each_prime(lo, hi, [&](uint64_t p) { expected.push_back(p); });
+    assert(window && std::vector<uint64_t>(window->begin(), window->end()) == expected);
+    assert(window->is_prime(1693182318746371ULL) && window->is_prime(1693182318747503ULL));
+    assert(window->rank(1693182318747503ULL) == window->rank(1693182318746372ULL));
+    assert(!window->is_prime(2) && !window->is_prime(1693182318746373ULL));
+    std::remove(path.c_str());
+    
+    // Empty ranges and foreign bytes
+    const std::vector<unsigned char> garbage(200, 7);
+    assert(!CNTCL::prime_table::view(garbage));
+    assert(!CNTCL::prime_table::open((std::filesystem::temp_directory_path() / "cntcl_no_such_table.bin").string()));
+    assert(CNTCL::write_prime_table(path, 24, 28));
+    auto empty = CNTCL::prime_table::open(path);
+    assert(empty && empty->size() == 0 && empty->begin() == empty->end() && !empty->is_prime(25));
+    std::remove(path.c_str());
+    
+    std::cout << "All prime table tests passed!\n";
+}
+
+// Test the rank/select prime bitmap
+void test_prime_bitmap() {
+    std::cout << "Testing rank/select prime bitmap...\n";
+    
+    const auto primes = CNTCL::simd_sieve(10000000);
+    for (uint64_t limit : {10000000ULL, 9999991ULL, 1680ULL * 5 - 1, 1680ULL * 5}) {
+        for (uint32_t threads : {1u, 4u}) {
+            const CNTCL::prime_bitmap bitmap(limit, threads);
+            const size_t count = std::upper_bound(primes.begin(), primes.end(), limit) - primes.begin();
+            assert(bitmap.pi(limit) == count && bitmap.pi(limit + 100) == count);
+            
+            // pi and is_prime at every n, nth for every k
+            size_t below = 0;
+            for (uint64_t n = 0; n <= limit; n++) {
+                const bool prime = below < count && primes[below] == n;
+                below += prime;
+                assert(bitmap.is_prime(n) == prime);
+                assert(bitmap.pi(n) == below);
+            }
+            for (size_t k = 0; k < count; k++) assert(bitmap.nth(k + 1) == primes[k]);
+            assert(bitmap.nth(0) == 0 && bitmap.nth(count + 1) == 0);
+        }
+    }
+    
+    // Tiny limits fall inside the first wheel bytes
+    for (uint64_t limit = 0; limit < 40; limit++) {
+        const CNTCL::prime_bitmap bitmap(limit, 2);
+        uint64_t count = 0;
+        for (uint64_t n = 0; n <= limit; n++) {
+            count += CNTCL::is_prime(n);
+            assert(bitmap.pi(n) == count && bitmap.is_prime(n) == CNTCL::is_prime(n));
+            if (CNTCL::is_prime(n)) assert(bitmap.nth(count) == n);
+        }
+    }
+    
+    // A fraction of the 4 bytes per prime of the sieve vector
+    const CNTCL::prime_bitmap large(100000000);
+    assert(large.pi(100000000) == 5761455 && large.nth(5761455) == 99999989);
+    assert(large.memory_bytes() * 4 < 5761455 * sizeof(uint32_t));
+    
+    std::cout << "All prime bitmap tests passed!\n";
+}
+
+// Test nth, next and previous prime
+void test_nth_and_next_prime() {
+    std::cout << "Testing nth_prime, next_prime and prev_prime...\n";
+    
+    // The first primes one by one, then a stride through those below 2 * 10^6
+    const auto primes = CNTCL::simd_sieve(2000000);
+    for (size_t k = 0; k < 2000; k++) assert(CNTCL::nth_prime(k + 1) == primes[k]);
+    for (size_t k = 2000; k < primes.size(); k += 997) assert(CNTCL::nth_prime(k + 1, 2) == primes[k]);
+    assert(CNTCL::nth_prime(0) == 0);
+    
+    // Li^-1 undershoots, so these walk up; the downward walk is checked directly
+    assert(CNTCL::nth_prime(1000000) == 15485863);
+    assert(CNTCL::nth_prime(10000000) == 179424673);
+    assert(CNTCL::nth_prime(100000000) == 2038074743);
+    assert(CNTCL::nth_prime(1000000000) == 22801763489ULL);
+    assert(CNTCL::detail::nth_prime_at_or_below(15485863, 1) == 15485863);
+    assert(CNTCL::detail::nth_prime_at_or_below(15485866, 1000000) == 2);
+    assert(CNTCL::detail::nth_prime_at_or_below(179424673, 10000000 - 1000000 + 1) == 15485863);
+    
+    for (uint64_t x = 0; x < 2000000; x++) {
+        const auto above = std::upper_bound(primes.begin(), primes.end(), x);
+        const auto below = std::lower_bound(primes.begin(), primes.end(), x);
+        if (above != primes.end()) assert(CNTCL::next_prime(x) == *above);
+        assert(CNTCL::prev_prime(x) == (below == primes.begin() ? 0 : *(below - 1)));
+    }
+    
+    // Around powers of two, the 1132 gap and the top of the 64-bit range
+    for (uint64_t x = 1ULL << 33; x < (1ULL << 33) + 5000; x++) {
+        uint64_t next = x + 1, prev = x - 1;
+        while (!CNTCL::is_probable_prime(next)) next++;
+        while (!CNTCL::is_probable_prime(prev)) prev--;
+        assert(CNTCL::next_prime(x) == next && CNTCL::prev_prime(x) == prev);
+    }
+    assert(CNTCL::next_prime(1693182318746371ULL) == 1693182318747503ULL);
+    assert(CNTCL::prev_prime(1693182318747503ULL) == 1693182318746371ULL);
+    assert(CNTCL::next_prime(1ULL << 63) == (1ULL << 63) + 29);
+    assert(CNTCL::prev_prime(1ULL << 63) == (1ULL << 63) - 25);
+    assert(CNTCL::prev_prime(UINT64_MAX) == 18446744073709551557ULL);
+    assert(CNTCL::next_prime(18446744073709551556ULL) == 18446744073709551557ULL);
+    assert(CNTCL::next_prime(18446744073709551557ULL) == 0);
+    
+    std::cout << "All nth/next/prev prime tests passed!\n";
+}
+
+// Test the cntcl tool on a piped stream
+void test_cli_stream() {
+    std::cout << "Testing cntcl on a piped stream...\n";
+#ifdef CNTCL_CLI_PATH
+    // Space-separated numbers with no newline, long enough that the 4 MiB
+    // stream chunks end inside a token
+    const std::string path = (std::filesystem::temp_directory_path() / "cntcl_test_stream.txt").string();
+    std::string input, expected;
+    for (uint64_t n = 1000000000; n < 1000600000; n++) {
+        input += std::to_string(n) + ' ';
+        expected += std::to_string(n) + (CNTCL::is_probable_prime(n) ? ": 1\n" : ": 0\n");
+    }
+    input.pop_back();
+    std::FILE* file = std::fopen(path.c_str(), "wb");
+    assert(file != nullptr);
+    std::fwrite(input.data(), 1, input.size(), file);
+    std::fclose(file);
+
+    for (const char* threads : {"1", "3"}) {
+        const std::string command = "cat '" + path + "' | '" CNTCL_CLI_PATH "' isprime --threads " + threads;
+        std::FILE* pipe = popen(command.c_str(), "r");
+        assert(pipe != nullptr);
+        std::string output;
+        char buffer[1 << 16];
+        for (size_t got; (got = std::fread(buffer, 1, sizeof(buffer), pipe)) > 0;) output.append(buffer, got);
+        assert(pclose(pipe) == 0);
+        assert(output == expected);
+    }
+    std::filesystem::remove(path);
+#endif
+    std::cout << "All cntcl stream tests passed!\n";
+}
+
+// Test std::pmr allocators on container-returning APIs
+void test_pmr_allocators() {
+    std::cout << "Testing std::pmr allocator support...\n";
+    
+    // A per-request arena that cannot grow: every result must fit in it
+    static std::byte buffer[1 << 20];
+    std::pmr::monotonic_buffer_resource arena(buffer, sizeof(buffer), std::pmr::null_memory_resource());
+    std::pmr::polymorphic_allocator<uint64_t> alloc(&arena);
+    auto in_arena = [&](const auto& v) {
+        const auto* p = reinterpret_cast<const std::byte*>(v.data());
+        return v.get_allocator().resource() == &arena && p >= buffer && p < buffer + sizeof(buffer);
+    };
+    
+    const CNTCL::pmr::vector<uint64_t> factors = CNTCL::prime_factors(uint64_t(1000000007) * 998244353 * 12, alloc);
+    assert(in_arena(factors) && (factors == CNTCL::pmr::vector<uint64_t>{2, 2, 3, 998244353, 1000000007}));
+    const auto primes = CNTCL::simd_sieve(10000, std::pmr::polymorphic_allocator<uint32_t>(&arena));
+    assert(in_arena(primes) && primes.size() == 1229);
+    
+    const std::vector<uint64_t> f = {1, 0, 1};
+    assert(in_arena(CNTCL::roots_mod_p(f, 1000000009, alloc)));
+    const auto solutions = CNTCL::solve_poly_congruence(f, 1625, alloc);
+    assert(in_arena(solutions) && (solutions == CNTCL::pmr::vector<uint64_t>{57, 307, 1318, 1568}));
+    assert(in_arena(CNTCL::roots_mod_prime_power(f, 5, 6, alloc)));
+    
+    assert(in_arena(CNTCL::smooth_numbers(100000, 7, alloc)));
+    const std::vector<uint64_t> candidates = {720, 721, 1024, 1000003};
+    assert(in_arena(CNTCL::smooth_parts(candidates, 1000, 1, alloc)));
+    const auto smooth = CNTCL::select_smooth(candidates, 1000, 1, alloc);
+    assert(in_arena(smooth) && (smooth == CNTCL::pmr::vector<uint64_t>{720, 721, 1024}));
+    
+    assert(in_arena(CNTCL::partition_table_mod(1000, 1000000007, alloc)));
+    assert(in_arena(CNTCL::bell_numbers_mod(100, 1000000007, alloc)));
+    assert(in_arena(CNTCL::catalan_numbers_mod(100, 1000000007, alloc)));
+    assert(in_arena(CNTCL::bell_numbers(20, alloc)) && in_arena(CNTCL::catalan_numbers(30, alloc)));
+    assert(CNTCL::partition_table<uint64_t>(100, alloc)[100] == 190569292);
+    
+    // Big integers and their tables share the arena too
+    const auto big = CNTCL::factorial(50, alloc);
+    assert(big.get_allocator().resource() == &arena);
+    assert(to_string(big) == "30414093201713378043612608166064768844377641568960512000000000000");
+    
+    // Resetting frees the request's work at once; the thread-local prime
+    // cache does not live in the arena and survives it
+    CNTCL::PrimeChecker::is_prime_cached(1000003);
+    arena.release();
+    assert(CNTCL::PrimeChecker::is_prime_cached(1000003));
+    
+    std::cout << "All pmr allocator tests passed!\n";
+}
+
+// Test caller-provided output buffers
+void test_output_buffers() {
+    std::cout << "Testing caller-provided output buffers...\n";
+    
+    // One buffer reused across calls of every size
+    std::vector<uint32_t> buffer(CNTCL::simd_sieve_capacity(2000000));
+    for (uint32_t limit : {0u, 1u, 2u, 3u, 4u, 13u, 14u, 100u, 65536u, 1000000u, 2000000u, 999983u}) {
+        const auto expected = CNTCL::simd_sieve(limit);
+        assert(CNTCL::simd_sieve_capacity(limit) >= expected.size());
+        const size_t count = CNTCL::simd_sieve_into(limit, buffer);
+        assert(count == expected.size() && std::equal(expected.begin(), expected.end(), buffer.begin()));
+    }
+    for (uint32_t limit = 2; limit < 5000; limit++) assert(CNTCL::simd_sieve_capacity(limit) >= CNTCL::simd_sieve(limit).size());
+    
+    // A short buffer takes the first primes and no more
+    std::array<uint32_t, 10> first{};
+    first.back() = 7;
+    assert(CNTCL::simd_sieve_into(1000000, std::span(first).first(9)) == 9 && first[8] == 23 && first.back() == 7);
+    assert(CNTCL::simd_sieve_into(1000000, {}) == 0);
+    
+    // Factors straight into a column of a caller's structure
+    struct columns {
+        std::array<uint64_t, 64> factor;
+        std::array<uint32_t, 64> row;
+    } table{};
+    uint64_t* end = table.factor.data();
+    for (uint64_t n : {840ULL, 1ULL, 1000000007ULL * 998244353ULL, 600851475143ULL, 1ULL << 40}) {
+        uint64_t* next = CNTCL::prime_factors(n, end);
+        const auto expected = CNTCL::prime_factors(n);
+        assert(std::equal(end, next, expected.begin(), expected.end()));
+        end = next;
+    }
+    assert(end - table.factor.data() == 6 + 0 + 2 + 4 + 40);
+    
+    // Wide integers and output iterators
+    using u128 = CNTCL::uint_t<128>;
+    const u128 composite = u128(18446744073709551557ULL) * u128(4294967291ULL) * u128(1000003);
+    std::vector<u128> wide;
+    CNTCL::prime_factors(composite, std::back_inserter(wide));
+    assert(wide.size() == 3 && wide[0] == u128(1000003) && wide[2] == u128(18446744073709551557ULL));
+    
+    std::cout << "All output buffer tests passed!\n";
+}
+
+// Test aligned bit arrays
+void test_bit_arrays() {
+    std::cout << "Testing aligned bit arrays...\n";
+    
+    using CNTCL::detail::bit_array;
+    for (size_t size : {0, 1, 63, 64, 65, 511, 512, 513, 100000}) {
+        bit_array bits(size);
+        assert(bits.size() == size && bits.word_count() == (size + 63) / 64);
+        assert(bits.block_count() == (size + 511) / 512);
+        assert(reinterpret_cast<uintptr_t>(bits.words()) % 64 == 0);
+        assert(bits.count() == 0 && bits.find_next(0) == size);
+        
+        // Every third bit, checked by test, count and find_next
+        std::vector<bool> expected(size, false);
+        for (size_t i = 0; i < size; i += 3) { bits.set(i); expected[i] = true; }
+        for (size_t i = 0; i < size; i += 6) { bits.reset(i); expected[i] = false; }
+        for (size_t i = 0; i < size; i++) assert(bits.test(i) == expected[i]);
+        assert(bits.count() == size_t(std::count(expected.begin(), expected.end(), true)));
+        for (size_t i = 0; i < size; i += 5) {
+            const size_t next = std::find(expected.begin() + i, expected.end(), true) - expected.begin();
+            assert(bits.find_next(i) == next);
+        }
+        
+        // Filling with ones leaves the padding clear; copies are deep
+        bits.assign(size, true);
+        assert(bits.count() == size && bits.find_next(size) == size);
+        bit_array copy = bits;
+        if (size > 0) {
+            copy.reset(size - 1);
+            assert(bits.test(size - 1) && copy.count() == size - 1);
+        }
+        bit_array moved = std::move(copy);
+        assert(moved.size() == size && copy.size() == 0);
+    }
+    
+    // Block views cover whole cache lines of the word storage
+    bit_array bits(1000);
+    bits.block(1)[7] = ~uint64_t(0);
+    bits.clear_tail();
+    assert(bits.count() == 1000 - 960 && bits.find_next(0) == 960);
+    assert(bits.block(1).data() == bits.words() + 8);
+    
+    // The sieves built on it agree with a plain one
+    std::vector<bool> composite(200001, false);
+    std::vector<uint32_t> plain;
+    for (uint32_t n = 2; n <= 200000; n++) {
+        if (composite[n]) continue;
+        plain.push_back(n);
+        for (uint64_t m = uint64_t(n) * n; m <= 200000; m += n) composite[m] = true;
+    }
+    for (uint32_t limit : {2u, 3u, 127u, 128u, 129u, 200000u}) {
+        const auto primes = CNTCL::simd_sieve(limit);
+        assert(primes == std::vector<uint32_t>(plain.begin(), std::upper_bound(plain.begin(), plain.end(), limit)));
+    }
+    
+    std::cout << "All bit array tests passed!\n";
+}
+
+// Test the hugepage arena memory resource
+void test_hugepage_arena() {
+    std::cout << "Testing hugepage arena...\n";
+    
+    CNTCL::hugepage_arena arena;
+    const size_t page = CNTCL::hugepage_arena::huge_page;
+    
+    // Large blocks are whole, aligned pages and come back on the next request
+    void* a = arena.allocate(3 * page + 1, 64);
+    assert(reinterpret_cast<uintptr_t>(a) % page == 0);
+    std::memset(a, 0xab, 3 * page + 1);
+    arena.deallocate(a, 3 * page + 1, 64);
+    assert(arena.cached_bytes() == 4 * page);
+    void* b = arena.allocate(4 * page, 64);
+    assert(b == a && arena.cached_bytes() == 0);
+    
+    // A block more than twice the request is left for larger ones
+    arena.deallocate(b, 4 * page, 64);
+    void* c = arena.allocate(page, 64);
+    assert(c != b && arena.cached_bytes() == 4 * page);
+    arena.deallocate(c, page, 64);
+    assert(arena.hugetlb_bytes() <= arena.mapped_bytes());
+    arena.release();
+    assert(arena.cached_bytes() == 0 && arena.mapped_bytes() == 0);
+    
+    // Small requests pass through to the upstream resource
+    void* small = arena.allocate(100, 8);
+    assert(arena.cached_bytes() == 0);
+    arena.deallocate(small, 100, 8);
+    assert(arena.cached_bytes() == 0);
+    
+    // A block is found by its address, even when freed with a size below min_bytes
+    void* mismatched = arena.allocate(page, 64);
+    arena.deallocate(mismatched, 100, 64);
+    assert(arena.cached_bytes() == page);
+    arena.release();
+    
+    // Repeated sieves reuse the same mappings; results match the heap's
+    const auto expected = CNTCL::simd_sieve(20000000);
+    for (int round = 0; round < 3; round++) {
+        const auto primes = CNTCL::simd_sieve(20000000, std::pmr::polymorphic_allocator<uint32_t>(&arena));
+        assert(std::equal(primes.begin(), primes.end(), expected.begin(), expected.end()));
+    }
+    const size_t mapped = arena.mapped_bytes();
+    (void)CNTCL::simd_sieve(20000000, std::pmr::polymorphic_allocator<uint32_t>(&arena));
+    assert(arena.mapped_bytes() == mapped && arena.cached_bytes() == mapped);
+    
+    const CNTCL::prime_bitmap bitmap(10000000, 2, &arena);
+    assert(bitmap.pi(10000000) == 664579 && bitmap.nth(664579) == 9999991);
+    
+    std::cout << "All hugepage arena tests passed!\n";
+}
+
+// Test division-free trial division
+void test_trial_division() {
+    std::cout << "Testing division-free trial division...\n";
+    
+    // Every table entry inverts its prime and bounds its multiples
+    const auto& table = CNTCL::detail::trial_table;
+    assert(CNTCL::detail::trial_divisor_count == 171 && table.prime[170] == 1021);
+    for (size_t k = 0; k < CNTCL::detail::trial_divisor_count; k++) {
+        const uint64_t p = table.prime[k];
+        assert(CNTCL::is_prime(p) && p * table.inverse[k] == 1 && table.limit[k] == UINT64_MAX / p);
+    }
+    
+    // The scan finds the smallest small prime factor up to sqrt(n)
+    for (uint64_t n = 1; n < 200000; n++) {
+        const size_t k = CNTCL::detail::next_trial_divisor(n, 0);
+        uint64_t smallest = 0;
+        for (uint64_t p = 3; p < 1024 && p * p <= n && !smallest; p += 2) {
+            if (n % p == 0) smallest = p;
+        }
+        if (smallest != 0) assert(k < CNTCL::detail::trial_divisor_count && table.prime[k] == smallest);
+        else assert(k == CNTCL::detail::trial_divisor_count || n % table.prime[k] == 0);
+    }
+    
+    // Factorizations through the kernel, at full width and beyond 64 bits
+    for (uint64_t n : {1021ULL * 1021 * 1021 * 1021 * 1021 * 1021, 18446744073709551557ULL,
+                       1021ULL * 1019 * 9 * 997 * 1000003, 3486784401ULL * 5 * 5 * 7}) {
+        uint64_t product = 1;
+        const auto factors = CNTCL::prime_factors(n);
+        for (uint64_t p : factors) product *= p;
+        assert(product == n && std::is_sorted(factors.begin(), factors.end()));
+    }
+    const unsigned __int128 wide = (unsigned __int128)(1021 * 1021 * 45) * 18446744073709551557ULL;
+    const auto wide_factors = CNTCL::prime_factors(wide);
+    assert((wide_factors == std::vector<unsigned __int128>{3, 3, 5, 1021, 1021, 18446744073709551557ULL}));
+    
+    // Run-time is_prime agrees with the compile-time path
+    static_assert(CNTCL::is_prime(1048573) && !CNTCL::is_prime(1021 * 1031));
+    for (uint64_t n : {1048573ULL, 1021ULL * 1031, 1021ULL * 1021, 4294967291ULL, 1000003ULL * 1000033}) {
+        assert(CNTCL::is_prime(n) == CNTCL::is_probable_prime(n));
+    }
+    
+    std::cout << "All trial division tests passed!\n";
+}
+
+// Test the lazy factorization stream
+void test_factor_stream() {
+    std::cout << "Testing lazy factorization stream...\n";
+    
+    auto collect = [](auto n) {
+        std::vector<std::pair<decltype(n), unsigned>> factors;
+        auto stream = CNTCL::factor_stream(n);
+        for (auto f = stream.next(); !stream.done(); f = stream.next()) factors.push_back(f);
+        return factors;
+    };
+    using factors = std::vector<std::pair<uint64_t, unsigned>>;
+    
+    // Cheap tiers first and ascending, large primes afterwards
+    assert((collect(uint64_t(360)) == factors{{2, 3}, {3, 2}, {5, 1}}));
+    assert(collect(uint64_t(1)).empty() && collect(uint64_t(0)).empty());
+    assert((collect(uint64_t(1021) * 1021 * 1000003) == factors{{1021, 2}, {1000003, 1}}));
+    assert((collect(uint64_t(1000003) * 1000003 * 1000003 * 12) == factors{{2, 2}, {3, 1}, {1000003, 3}}));
+    
+    // Same factorization as prime_factors, each prime once
+    for (uint64_t n = 2; n < 30000; n++) {
+        const auto flat = CNTCL::prime_factors(n);
+        size_t i = 0;
+        for (const auto& [p, e] : collect(n)) {
+            assert(size_t(std::count(flat.begin(), flat.end(), p)) == e);
+            i += e;
+        }
+        assert(i == flat.size());
+    }
+    const unsigned __int128 wide = (unsigned __int128)18446744073709551557ULL * 4294967291ULL * 49;
+    const auto wide_factors = collect(wide);
+    assert(wide_factors.size() == 3 && wide_factors[0] == (std::pair<unsigned __int128, unsigned>{7, 2}));
+    
+    // Stopping after the first factor skips the rho tier entirely
+    auto stream = CNTCL::factor_stream(uint64_t(3) * uint64_t(4294967291) * 1000003);
+    assert(stream.next() == (std::pair<uint64_t, unsigned>{3, 1}) && !stream.done());
+    
+    std::cout << "All factor stream tests passed!\n";
+}
+
+// Test batched modpow
+void test_modpow_batch() {
+    std::cout << "Testing batched modpow...\n";
+    
+    uint64_t seed = 0x9e3779b97f4a7c15ULL;
+    auto next = [&] { seed ^= seed << 13; seed ^= seed >> 7; seed ^= seed << 17; return seed; };
+    
+    // Every path: even moduli, vector lanes below 2^32, scalar lanes above
+    for (uint64_t m : {1ULL, 2ULL, 1000000ULL, 3ULL, 65537ULL, 4294967291ULL, 4294967295ULL, 4294967297ULL,
+                       18446744073709551557ULL, 18446744073709551615ULL}) {
+        for (size_t count : {1, 7, 16, 37}) {
+            std::vector<uint64_t> bases(count), exps(count), out(count + 1, 42);
+            for (size_t i = 0; i < count; i++) {
+                bases[i] = next() >> (next() % 64);
+                exps[i] = next() >> (next() % 64);  // mixed lengths
+            }
+            exps[0] = 0;
+            assert(CNTCL::modpow_batch(bases, exps, m, std::span(out).first(count)) == count && out[count] == 42);
+            for (size_t i = 0; i < count; i++) assert(out[i] == CNTCL::modpow<uint64_t>(bases[i], exps[i], m));
+            
+            // One base, many exponents; and many bases, one exponent
+            const std::vector<uint64_t> one{next()};
+            assert(CNTCL::modpow_batch(one, exps, m, std::span(out).first(count)) == count);
+            for (size_t i = 0; i < count; i++) assert(out[i] == CNTCL::modpow<uint64_t>(one[0], exps[i], m));
+            assert(CNTCL::modpow_batch(bases, one, m, std::span(out).first(count)) == count);
+            for (size_t i = 0; i < count; i++) assert(out[i] == CNTCL::modpow<uint64_t>(bases[i], one[0], m));
+        }
+    }
+    
+    // Short inputs stop the batch; modulus 0 writes nothing
+    std::vector<uint64_t> out(10);
+    const std::vector<uint64_t> three{2, 3, 5}, four{10, 10, 10, 10};
+    assert(CNTCL::modpow_batch(three, four, 1000000007, out) == 3 && out[2] == 9765625);
+    assert(CNTCL::modpow_batch(three, four, 0, out) == 0);
+    
+    std::cout << "All batched modpow tests passed!\n";
+}
+
+// Test simultaneous multi-exponentiation
+void test_multi_modpow() {
+    std::cout << "Testing simultaneous multi-exponentiation...\n";
+    
+    uint64_t seed = 0x9e3779b97f4a7c15ULL;
+    auto next = [&] { seed ^= seed << 13; seed ^= seed >> 7; seed ^= seed << 17; return seed; };
+    using terms_t = std::vector<std::pair<uint64_t, uint64_t>>;
+    auto separate = [](const terms_t& terms, uint64_t m) {
+        uint64_t product = 1 % m;
+        for (const auto& [g, e] : terms) product = CNTCL::mulmod(product, CNTCL::modpow<uint64_t>(g, e, m), m);
+        return product;
+    };
+    
+    assert(CNTCL::multi_modpow({{2, 10}, {3, 2}}, 1000000007) == 9216);
+    assert(CNTCL::multi_modpow({}, 97) == 1 && CNTCL::multi_modpow({{5, 0}}, 1) == 0 && CNTCL::multi_modpow({{5, 3}}, 0) == 0);
+    
+    // Straus for a few terms, Pippenger for many; odd and even moduli
+    for (uint64_t m : {2ULL, 1000000ULL, 1ULL << 63, 3ULL, 4294967291ULL, 18446744073709551557ULL}) {
+        for (size_t k : {1, 2, 3, 10, 200}) {
+            terms_t terms(k);
+            for (auto& [g, e] : terms) { g = next(); e = next() >> (next() % 64); }
+            assert(CNTCL::multi_modpow(terms, m) == separate(terms, m));
+        }
+    }
+    
+    // Every window width of both methods
+    const uint64_t p = 18446744073709551557ULL;
+    const CNTCL::montgomery<uint64_t> mont(p);
+    terms_t terms(40);
+    for (auto& [g, e] : terms) { g = next(); e = next(); }
+    const uint64_t expected = separate(terms, p);
+    for (unsigned w = 1; w <= 8; w++) assert(CNTCL::detail::straus_modpow(mont, std::span(std::as_const(terms)), 64, w) == expected);
+    for (unsigned c = 1; c <= 12; c++) assert(CNTCL::detail::pippenger_modpow(mont, std::span(std::as_const(terms)), 64, c) == expected);
+    
+    std::cout << "All multi-exponentiation tests passed!\n";
+}
+
+// Test matrices over Z/pZ
+void test_mat_mod() {
+    std::cout << "Testing matrices mod p...\n";
+    
+    uint64_t seed = 0x2545f4914f6cdd1dULL;
+    auto next = [&] { seed ^= seed << 13; seed ^= seed >> 7; seed ^= seed << 17; return seed; };
+    auto naive = [](const auto& a, const auto& b, uint64_t p) {
+        const size_t n = a.size();
+        std::vector<uint32_t> c(n * n);
+        for (size_t i = 0; i < n; i++) {
+            for (size_t j = 0; j < n; j++) {
+                uint64_t s = 0;
+                for (size_t k = 0; k < n; k++) s = (s + uint64_t(a(i, k)) * b(k, j)) % p;
+                c[i * n + j] = static_cast<uint32_t>(s);
+            }
+        }
+        return c;
+    };
+    
+    // Fibonacci numbers from powers of [[1, 1], [1, 0]]
+    const CNTCL::mat_mod<> fib{{1, 1}, {1, 0}};
+    assert(fib.pow(0) == CNTCL::mat_mod<>::identity(2));
+    assert(fib.pow(10)(0, 1) == 55 && fib.pow(90)(0, 1) == 2880067194370816120ULL % 998244353);
+    assert((fib * fib + fib)(0, 0) == 3 && (fib - fib) == CNTCL::mat_mod<>(2));
+    assert((fib * CNTCL::mat_mod<>(3)).size() == 0);
+    
+    // Register tiles, ragged edges and a second column panel, against the
+    // schoolbook product; small, mid-size and near-2^32 moduli
+    for (size_t n : {1, 5, 16, 37, 70}) {
+        std::vector<uint32_t> x(n * n), y(n * n);
+        for (auto& v : x) v = static_cast<uint32_t>(next());
+        for (auto& v : y) v = static_cast<uint32_t>(next());
+        const CNTCL::mat_mod<2> a2(n, x), b2(n, y);
+        const CNTCL::mat_mod<> a(n, x), b(n, y);
+        const CNTCL::mat_mod<4294967291u> aw(n, x), bw(n, y);
+        assert(std::ranges::equal((a2 * b2).entries(), naive(a2, b2, 2)));
+        assert(std::ranges::equal((a * b).entries(), naive(a, b, 998244353)));
+        assert(std::ranges::equal((aw * bw).entries(), naive(aw, bw, 4294967291u)));
+        assert(a.pow(5) == a * a * a * a * a);
+    }
+    const size_t n = 300;
+    std::vector<uint32_t> x(n * n), y(n * n), v(n);
+    for (auto& e : x) e = static_cast<uint32_t>(next() % 998244353);
+    for (auto& e : y) e = static_cast<uint32_t>(next() % 998244353);
+    for (auto& e : v) e = static_cast<uint32_t>(next() % 998244353);
+    const CNTCL::mat_mod<> a(n, x), b(n, y);
+    assert((a * b).apply(v) == a.apply(b.apply(v)));
+    
+    // A linear recurrence 2^40 steps ahead: x' = x, y' = x + y
+    const CNTCL::mat_mod<> step{{1, 0}, {1, 1}};
+    assert(step.pow(uint64_t(1) << 40).apply(std::vector<uint32_t>{1, 0}) ==
+           (std::vector<uint32_t>{1, static_cast<uint32_t>((uint64_t(1) << 40) % 998244353)}));
+    
+    std::cout << "All matrix tests passed!\n";
+}
+
 // Stress test
 void stress_test() {
     std::cout << "Running stress tests...\n";
@@ -185,8 +1533,121 @@ void stress_test() {
     std::cout << "Stress tests completed!\n";
 }
 
+// Times each multiplication rung at the top level (recursion still goes
+// through the tuned dispatch) to place the big_uint crossover thresholds
+void bench_big_multiplication() {
+    std::cout << "Benchmarking big_uint multiplication (ms per product)...\n";
+    std::cout << "  limbs   schoolbook   karatsuba       toom3         ntt\n";
+    
+    uint64_t seed = 0x9e3779b97f4a7c15ULL;
+    auto next = [&] { seed ^= seed << 13; seed ^= seed >> 7; seed ^= seed << 17; return seed; };
+    
+    for (size_t n : {16, 32, 64, 128, 256, 512, 1024, 2048, 4096, 8192, 16384, 32768}) {
+        std::vector<uint64_t> a(n), b(n), r(2 * n);
+        for (size_t i = 0; i < n; i++) { a[i] = next(); b[i] = next(); }
+        const int reps = static_cast<int>(std::max<size_t>(1, 20000 / n));
+        
+        auto time_rung = [&](auto&& mul) {
+            return measure_time([&] { for (int i = 0; i < reps; i++) mul(); }) / reps;
+        };
+        const double school = time_rung([&] { CNTCL::detail::mul_limbs_schoolbook(r.data(), a.data(), n, b.data(), n); });
+        const double kara = time_rung([&] { CNTCL::detail::mul_karatsuba(r.data(), a.data(), n, b.data(), n); });
+        const double toom = time_rung([&] { CNTCL::detail::mul_toom3(r.data(), a.data(), n, b.data(), n); });
+        const double ntt = time_rung([&] { CNTCL::detail::mul_ntt(r.data(), a.data(), n, b.data(), n); });
+        
+        std::printf("  %5zu %12.4f %11.4f %11.4f %11.4f\n", n, school, kara, toom, ntt);
+    }
+}
+
+// Times simd_sieve on bit_array against the std::vector<bool> version it replaced
+void bench_bit_arrays() {
+    std::cout << "Benchmarking simd_sieve on bit_array vs std::vector<bool> (ms)...\n";
+    std::cout << "      limit  vector<bool>   bit_array\n";
+    
+    auto sieve_vector_bool = [](uint32_t limit) {
+        std::vector<uint32_t> primes{2};
+        std::vector<bool> is_composite((limit + 1) / 2, false);
+        const uint32_t root = static_cast<uint32_t>(CNTCL::isqrt(limit));
+        for (uint32_t i = 3; i <= root; i += 2) {
+            if (is_composite[(i - 1) / 2]) continue;
+            for (uint64_t j = uint64_t(i) * i; j <= limit; j += 2 * i) is_composite[(j - 1) / 2] = true;
+        }
+        for (uint64_t i = 3; i <= limit; i += 2) {
+            if (!is_composite[(i - 1) / 2]) primes.push_back(static_cast<uint32_t>(i));
+        }
+        return primes;
+    };
+    for (uint32_t limit : {100000u, 1000000u, 10000000u, 100000000u}) {
+        const int reps = static_cast<int>(std::max<uint32_t>(1, 100000000 / limit));
+        size_t a = 0, b = 0;
+        const double old_time = measure_time([&] { for (int i = 0; i < reps; i++) a += sieve_vector_bool(limit).size(); }) / reps;
+        const double new_time = measure_time([&] { for (int i = 0; i < reps; i++) b += CNTCL::simd_sieve(limit).size(); }) / reps;
+        assert(a == b);
+        std::printf("  %9u %13.3f %11.3f\n", limit, old_time, new_time);
+    }
+}
+
+// Throughput of modpow_batch against a modpow loop, with 64-bit exponents
+void bench_modpow_batch() {
+    std::cout << "Benchmarking modpow_batch vs a modpow loop (ms per 100000)...\n";
+    std::cout << "                 modulus   modpow    batch\n";
+    
+    uint64_t seed = 0x9e3779b97f4a7c15ULL;
+    auto next = [&] { seed ^= seed << 13; seed ^= seed >> 7; seed ^= seed << 17; return seed; };
+    std::vector<uint64_t> bases(100000), exps(100000), out(100000);
+    for (size_t i = 0; i < bases.size(); i++) { bases[i] = next(); exps[i] = next(); }
+    
+    for (uint64_t m : {998244353ULL, 4294967291ULL, 1000000000000000003ULL, 18446744073709551557ULL}) {
+        uint64_t check = 0;
+        const double loop = measure_time([&] {
+            for (size_t i = 0; i < bases.size(); i++) check += CNTCL::modpow<uint64_t>(bases[i], exps[i], m);
+        });
+        const double batch = measure_time([&] { CNTCL::modpow_batch(bases, exps, m, out); });
+        for (uint64_t r : out) check -= r;
+        assert(check == 0);
+        std::printf("  %22llu %8.2f %8.2f\n", static_cast<unsigned long long>(m), loop, batch);
+    }
+}
+
+// Times mat_mod products against a loop that reduces every term
+void bench_mat_mod() {
+    std::cout << "Benchmarking mat_mod products vs a reduce-per-term loop (ms)...\n";
+    std::cout << "     n schoolbook   mat_mod\n";
+    
+    uint64_t seed = 0x2545f4914f6cdd1dULL;
+    auto next = [&] { seed ^= seed << 13; seed ^= seed >> 7; seed ^= seed << 17; return seed; };
+    for (size_t n : {64, 128, 256, 512}) {
+        std::vector<uint32_t> x(n * n), y(n * n), z(n * n);
+        for (auto& v : x) v = static_cast<uint32_t>(next() % 998244353);
+        for (auto& v : y) v = static_cast<uint32_t>(next() % 998244353);
+        const double loop = measure_time([&] {
+            for (size_t i = 0; i < n; i++) {
+                for (size_t j = 0; j < n; j++) {
+                    uint64_t s = 0;
+                    for (size_t k = 0; k < n; k++) s = (s + uint64_t(x[i * n + k]) * y[k * n + j]) % 998244353;
+                    z[i * n + j] = static_cast<uint32_t>(s);
+                }
+            }
+        });
+        const CNTCL::mat_mod<> a(n, x), b(n, y);
+        CNTCL::mat_mod<> c;
+        CNTCL::detail::mat_mod_scratch scratch;
+        const double tiled = measure_time([&] { CNTCL::mat_mod<>::multiply(a, b, c, scratch); });
+        assert(std::ranges::equal(c.entries(), z));
+        std::printf("  %4zu %10.2f %9.2f\n", n, loop, tiled);
+    }
+}
+
 // Main test function
-int main() {
+int main(int argc, char* argv[]) {
+    if (argc > 1 && std::string_view(argv[1]) == "--benchmark") {
+        bench_big_multiplication();
+        bench_bit_arrays();
+        bench_modpow_batch();
+        bench_mat_mod();
+        return 0;
+    }
+    
     std::cout << "=== CNTCL Library Test Suite ===\n\n";
     
     test_compile_time_functions();
@@ -204,6 +1665,81 @@ int main() {
     test_concurrency();
     std::cout << "\n";
     
+    test_partitions();
+    std::cout << "\n";
+    
+    test_combinatorial_tables();
+    std::cout << "\n";
+    
+    test_summatory_functions();
+    std::cout << "\n";
+    
+    test_jacobi_symbols();
+    std::cout << "\n";
+    
+    test_integer_roots();
+    std::cout << "\n";
+    
+    test_multiword_integers();
+    std::cout << "\n";
+    
+    test_big_integers();
+    std::cout << "\n";
+    
+    test_polynomials();
+    std::cout << "\n";
+    
+    test_polynomial_factorization();
+    std::cout << "\n";
+    
+    test_smooth_numbers();
+    std::cout << "\n";
+    
+    test_segmented_sieve();
+    std::cout << "\n";
+    
+    test_prime_gaps();
+    std::cout << "\n";
+    
+    test_prime_tables();
+    std::cout << "\n";
+    
+    test_prime_bitmap();
+    std::cout << "\n";
+    
+    test_nth_and_next_prime();
+    std::cout << "\n";
+    
+    test_cli_stream();
+    std::cout << "\n";
+    
+    test_pmr_allocators();
+    std::cout << "\n";
+    
+    test_output_buffers();
+    std::cout << "\n";
+    
+    test_bit_arrays();
+    std::cout << "\n";
+    
+    test_hugepage_arena();
+    std::cout << "\n";
+    
+    test_trial_division();
+    std::cout << "\n";
+    
+    test_factor_stream();
+    std::cout << "\n";
+    
+    test_modpow_batch();
+    std::cout << "\n";
+    
+    test_multi_modpow();
+    std::cout << "\n";
+    
+    test_mat_mod();
+    std::cout << "\n";
+    
     stress_test();
     std::cout << "\n";
     